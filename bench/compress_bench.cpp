@@ -0,0 +1,198 @@
+/* Compression benchmark
+ *
+ * Sizes and times the compressed_waveforms encoding against the protobuf and
+ * ascii_waveforms forms of the same waveforms.  The waveforms are the write
+ * test's: sigmoids rising to --peak with c stepping through --sample_size
+ * values between --min_c and --max_c, names drawn from 0of09 to 9of09, plus
+ * up to --noise counts of noise.  Every record is decoded again with
+ * waveform_decoder and checked before anything is timed.
+ *
+ * Built apart from dewd, from the repository root:
+ *
+ *   g++ -std=gnu++11 -O2 -Isrc bench/compress_bench.cpp -o compress_bench \
+ *     -lboost_system -lboost_chrono -lboost_program_options -lpthread
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <stdexcept>
+
+#include <boost/chrono.hpp>
+#include <boost/program_options.hpp>
+
+#include "wire.h"
+#include "waveform_codec.h"
+
+
+
+using namespace dew;
+namespace po = boost::program_options;
+
+using ::boost::chrono::steady_clock;
+using ::boost::chrono::duration;
+
+using ::std::string;
+using ::std::vector;
+
+using ::std::cout;
+using ::std::cerr;
+using ::std::endl;
+
+namespace
+{
+
+struct options {
+	size_t messages;
+	int samples;
+	double peak;
+	double min_c;
+	double max_c;
+	int sample_size;
+	int noise;
+	size_t rounds;
+	uint64_t seed;
+};
+
+struct waveform {
+	string name;
+	vector<int32_t> samples;
+};
+
+/* xorshift64*, enough for picking names and noise. */
+struct rng {
+	uint64_t s;
+	uint64_t operator()() {
+		s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+		return s * 0x2545F4914F6CDD1DULL;
+	}
+};
+
+vector<waveform> make_waveforms(const options& opt) {
+	rng next {opt.seed ? opt.seed : 1};
+	vector<waveform> out (opt.messages);
+	for(size_t k = 0 ; k < opt.messages ; ++k) {
+		out[k].name = std::to_string(next() % 10) + "of09";
+		double c = opt.min_c + (opt.max_c - opt.min_c)
+				* (opt.sample_size ? double(k % opt.sample_size) / opt.sample_size : 0);
+		int n = opt.samples;
+		for(int i = 0 ; i < n ; ++i) {
+			int32_t v = static_cast<int32_t>(opt.peak / (1 + std::exp(c*(n/2-i))));
+			if(opt.noise)
+				v += static_cast<int32_t>(next() % (2 * opt.noise + 1)) - opt.noise;
+			out[k].samples.push_back(v);
+		}
+	}
+	return out;
+}
+
+} //namespace
+
+
+
+int main(int argc, char** argv) {
+	try {
+		options opt;
+
+		po::options_description desc("Compression benchmark options");
+		desc.add_options()
+				("help,h", "Print help messages")
+				("messages", po::value<size_t>(&opt.messages)->default_value(10000),
+						"Waveforms in the stream")
+				("samples", po::value<int>(&opt.samples)->default_value(64),
+						"Samples per waveform")
+				("peak", po::value<double>(&opt.peak)->default_value(65000),
+						"Height of the waveforms")
+				("min_c", po::value<double>(&opt.min_c)->default_value(0.10),
+						"Smallest c")
+				("max_c", po::value<double>(&opt.max_c)->default_value(0.40),
+						"Largest c")
+				("sample_size", po::value<int>(&opt.sample_size)->default_value(100),
+						"Waveforms before c repeats, 0 for a fixed c")
+				("noise", po::value<int>(&opt.noise)->default_value(0),
+						"Largest noise added to a sample")
+				("rounds", po::value<size_t>(&opt.rounds)->default_value(20),
+						"Passes over the stream when timing")
+				("seed", po::value<uint64_t>(&opt.seed)->default_value(1),
+						"Seed for names and noise");
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		if(vm.count("help")) {
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+		if(opt.messages < 1 || opt.samples < 0)
+			throw std::runtime_error("Messages must be positive.");
+
+		auto waves = make_waveforms(opt);
+
+		size_t protobuf = 0, ascii = 0;
+		for(auto& w : waves) {
+			string pb;
+			append_flopoint(pb, w.name, w.samples.data(), w.samples.size());
+			protobuf += pb.size();
+			for(auto v : w.samples)
+				ascii += 1 + std::to_string(v).size();
+			ascii += 1;
+		}
+
+		string stream;
+		waveform_encoder encoder;
+		for(auto& w : waves)
+			encoder.encode(stream, w.name, w.samples.data(), w.samples.size());
+
+		waveform_decoder decoder;
+		auto p = reinterpret_cast<const uint8_t*>(stream.data());
+		auto end = p + stream.size();
+		string name;
+		vector<int32_t> samples;
+		for(size_t k = 0 ; k < waves.size() ; ++k)
+			if(!decoder.decode(p, end, name, samples) || name != waves[k].name
+					|| samples != waves[k].samples)
+				throw std::runtime_error("Record " + std::to_string(k) + " decoded wrongly.");
+		if(p != end)
+			throw std::runtime_error("Stream has bytes left over.");
+
+		double count = waves.size();
+		printf("%zu waveforms, %d samples\n", waves.size(), opt.samples);
+		printf("%-12s %9.1f bytes/msg\n", "protobuf", protobuf / count);
+		printf("%-12s %9.1f bytes/msg\n", "ascii", ascii / count);
+		printf("%-12s %9.1f bytes/msg   %.2fx smaller than protobuf\n", "compressed",
+				stream.size() / count, double(protobuf) / stream.size());
+
+		string out;
+		auto start = steady_clock::now();
+		for(size_t r = 0 ; r < opt.rounds ; ++r) {
+			waveform_encoder fresh;
+			out.clear();
+			for(auto& w : waves)
+				fresh.encode(out, w.name, w.samples.data(), w.samples.size());
+		}
+		double seconds = duration<double>(steady_clock::now() - start).count();
+		printf("%-12s %9.1f ns/msg\n", "encode", seconds * 1e9 / (opt.rounds * count));
+
+		start = steady_clock::now();
+		size_t sink = 0;
+		for(size_t r = 0 ; r < opt.rounds ; ++r) {
+			waveform_decoder fresh;
+			p = reinterpret_cast<const uint8_t*>(out.data());
+			end = p + out.size();
+			while(p < end && fresh.decode(p, end, name, samples))
+				sink += samples.size();
+		}
+		seconds = duration<double>(steady_clock::now() - start).count();
+		printf("%-12s %9.1f ns/msg   (%zu)\n", "decode",
+				seconds * 1e9 / (opt.rounds * count), sink % 10);
+
+	} catch(std::exception& e) {
+		cerr << "Unhandled Exception reached the top of main: "
+				<< e.what() << ", application will now exit" << endl;
+		return 2;
+	}
+
+	return 0;
+}
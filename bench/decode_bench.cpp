@@ -0,0 +1,213 @@
+/* Decode benchmark
+ *
+ * Times the ways dewd can get the samples out of a FloPointMessage:
+ *
+ *   parse          FloPointMessage::ParseFromString into a reused message
+ *   scan+bytewise  scan_flopoint, then the wheight varints a byte at a time
+ *   scan+packed    scan_flopoint, then decode_int32_runs
+ *   raw            read_raw_waveform, with the samples sent as a raw record
+ *
+ * and, on the packed wheight field alone, the byte at a time loop against
+ * decode_packed_int32.  Messages are shaped like the write test's: a sigmoid
+ * rising to --peak, plus a little noise, so most samples take three bytes and
+ * the foot of the curve one or two.  Every method is checked against
+ * ParseFromString before it is timed.
+ *
+ * Built apart from dewd, from the repository root:
+ *
+ *   g++ -std=gnu++11 -O2 -include fppb/flopointpb.pb.h -Isrc \
+ *     bench/decode_bench.cpp fppb/flopointpb.pb.cc -o decode_bench \
+ *     -lprotobuf -lboost_system -lboost_chrono -lboost_program_options \
+ *     -lpthread
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#include <boost/asio.hpp>
+#include <boost/chrono.hpp>
+#include <boost/program_options.hpp>
+
+#include "structs.h"
+#include "types.h"
+#include "utils.h"
+
+
+
+using namespace dew;
+namespace po = boost::program_options;
+
+using ::boost::chrono::steady_clock;
+using ::boost::chrono::duration;
+
+using ::std::string;
+using ::std::vector;
+
+using ::std::cout;
+using ::std::cerr;
+using ::std::endl;
+
+namespace
+{
+
+struct options {
+	size_t messages;
+	int samples;
+	double peak;
+	size_t rounds;
+	u64 seed;
+};
+
+vector<string> encode_messages(const options& opt) {
+	xoshiro256ss rng (opt.seed);
+	vector<string> out;
+	for(size_t n = 0 ; n < opt.messages ; ++n) {
+		flopointpb::FloPointMessage fpm;
+		fpm.set_name(std::to_string(n % 10) + "of09");
+		auto wf = fpm.mutable_waveform();
+		double c = 0.10 + 0.30 * (rng() % 1000) / 1000.0;
+		for(int i = 0 ; i < opt.samples ; ++i) {
+			double v = opt.peak / (1 + std::exp(c*(opt.samples/2-i)));
+			wf->add_wheight(static_cast<int>(v) + static_cast<int>(rng() % 16));
+		}
+		out.emplace_back();
+		fpm.SerializeToString(&out.back());
+	}
+	return out;
+}
+
+bool bytewise(const vector<byte_run>& runs, vector<int32_t>& out) {
+	out.clear();
+	for(auto& run : runs) {
+		const uint8_t* p = run.data;
+		const uint8_t* end = p + run.size;
+		while(p < end) {
+			uint64_t n;
+			if(!read_varint(p, end, n))
+				return false;
+			out.push_back(static_cast<int32_t>(n));
+		}
+	}
+	return true;
+}
+
+/* Runs fn over every message rounds times and prints ns per message. */
+void time(const char* label, const options& opt, size_t count,
+		const std::function<size_t(size_t)>& fn) {
+	size_t sink = 0;
+	auto start = steady_clock::now();
+	for(size_t r = 0 ; r < opt.rounds ; ++r)
+		for(size_t i = 0 ; i < count ; ++i)
+			sink += fn(i);
+	double seconds = duration<double>(steady_clock::now() - start).count();
+	double per = seconds * 1e9 / (opt.rounds * count);
+	printf("%-16s %9.1f ns/msg %9.1f Msamples/s   (%zu)\n", label, per,
+			opt.samples / per * 1e3, sink % 10);
+}
+
+} //namespace
+
+
+
+int main(int argc, char** argv) {
+	try {
+		options opt;
+
+		po::options_description desc("Decode benchmark options");
+		desc.add_options()
+				("help,h", "Print help messages")
+				("messages", po::value<size_t>(&opt.messages)->default_value(1000),
+						"Distinct messages, decoded round robin")
+				("samples", po::value<int>(&opt.samples)->default_value(64),
+						"Waveform samples per message")
+				("peak", po::value<double>(&opt.peak)->default_value(65000),
+						"Height of the waveforms")
+				("rounds", po::value<size_t>(&opt.rounds)->default_value(1000),
+						"Passes over the messages per method")
+				("seed", po::value<u64>(&opt.seed)->default_value(1),
+						"Seed for the messages");
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		if(vm.count("help")) {
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+		if(opt.messages < 1 || opt.samples < 1)
+			throw std::runtime_error("Messages and samples must be positive.");
+
+		auto messages = encode_messages(opt);
+		vector<string> raws (messages.size());
+		size_t bytes = 0;
+		for(auto& m : messages)
+			bytes += m.size();
+
+		/* The views and the wheight runs, found once for the decode only runs. */
+		vector<flopoint_view> views (messages.size());
+		flopointpb::FloPointMessage fpm;
+		vector<int32_t> a, b;
+		for(size_t i = 0 ; i < messages.size() ; ++i) {
+			if(!fpm.ParseFromString(messages[i]) || !scan_flopoint(messages[i], views[i]))
+				throw std::runtime_error("Message " + std::to_string(i) + " did not parse.");
+			vector<int32_t> want (fpm.waveform().wheight().begin(), fpm.waveform().wheight().end());
+			if(!bytewise(views[i].wheight, a) || !decode_int32_runs(views[i].wheight, b)
+					|| a != want || b != want || views[i].name_string() != fpm.name())
+				throw std::runtime_error("Message " + std::to_string(i) + " decoded wrongly.");
+			flopoint_view raw;
+			if(!append_raw_waveform(raws[i], fpm.name(), want.data(), want.size())
+					|| !read_raw_waveform(raws[i], raw, a)
+					|| a != want || raw.name_string() != fpm.name())
+				throw std::runtime_error("Record " + std::to_string(i) + " decoded wrongly.");
+		}
+		size_t raw_bytes = 0;
+		for(auto& r : raws)
+			raw_bytes += r.size();
+		printf("%zu messages, %d samples, %.1f bytes per message, %.1f as raw records\n",
+				messages.size(), opt.samples, (double)bytes / messages.size(),
+				(double)raw_bytes / raws.size());
+
+		size_t count = messages.size();
+		flopoint_view view;
+		vector<int32_t> samples;
+
+		time("parse", opt, count, [&](size_t i) {
+			fpm.ParseFromString(messages[i]);
+			return (size_t)fpm.waveform().wheight_size();
+		});
+		time("scan+bytewise", opt, count, [&](size_t i) {
+			scan_flopoint(messages[i], view);
+			bytewise(view.wheight, samples);
+			return samples.size();
+		});
+		time("scan+packed", opt, count, [&](size_t i) {
+			scan_flopoint(messages[i], view);
+			decode_int32_runs(view.wheight, samples);
+			return samples.size();
+		});
+		time("raw", opt, count, [&](size_t i) {
+			read_raw_waveform(raws[i], view, samples);
+			return samples.size();
+		});
+		time("bytewise only", opt, count, [&](size_t i) {
+			bytewise(views[i].wheight, samples);
+			return samples.size();
+		});
+		time("packed only", opt, count, [&](size_t i) {
+			decode_int32_runs(views[i].wheight, samples);
+			return samples.size();
+		});
+
+	} catch(std::exception& e) {
+		cerr << "Unhandled Exception reached the top of main: "
+				<< e.what() << ", application will now exit" << endl;
+		return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,315 @@
+/* Fan-out benchmark
+ *
+ * Drives dispatcher::delivery with pre-encoded FloPointMessages while 1 to
+ * 10000 subscribers listen on raw_waveforms, ascii_waveforms, protobuf_all and
+ * the *_enc channels.  Reports messages/s, MB/s sent, allocations per message
+ * and bytes allocated per message.  Every response the dispatcher builds is a
+ * fresh allocation, so the last figure bounds the bytes copied per message
+ * from above.
+ *
+ * Subscribers are network_sessions on loopback TCP connections.  They
+ * subscribe through execute_network_command like any client, and every write
+ * goes through the session's gather write and its completion.  The far end of
+ * each connection is read as fast as data arrives and thrown away.  A run
+ * ends once every subscriber's writes have completed.  Each subscriber takes
+ * two descriptors, so 10000 of them need a limit above 20000.
+ *
+ * Built apart from dewd, from the repository root:
+ *
+ *   g++ -std=gnu++11 -O2 -include fppb/flopointpb.pb.h -Isrc \
+ *     bench/fanout_bench.cpp fppb/flopointpb.pb.cc -o fanout_bench \
+ *     -lprotobuf -lboost_system -lboost_chrono -lboost_program_options \
+ *     -lboost_filesystem -lpthread
+ */
+
+#define AJS_HACK
+
+#include <ctime>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <new>
+
+#include <sys/resource.h>
+
+#include <boost/version.hpp>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include "structs.h"
+#include "types.h"
+#include "utils.h"
+
+#include "network_session.hpp"
+#include "metrics_session.hpp"
+#include "command_graph.hpp"
+
+#include "session.hpp"
+#include "serial_session.hpp"
+
+
+
+using namespace dew;
+namespace po = boost::program_options;
+
+using ::boost::asio::io_service;
+using ::boost::asio::ip::tcp;
+
+using ::boost::chrono::steady_clock;
+using ::boost::chrono::duration;
+
+using ::std::string;
+using ::std::vector;
+using ::std::shared_ptr;
+using ::std::make_shared;
+
+using ::std::cout;
+using ::std::cerr;
+using ::std::endl;
+
+/*-----------------------------------------------------------------------------
+ * Allocation counting.  Every allocation in the program goes through here;
+ * only those made while counting is set are tallied.
+ */
+namespace
+{
+	bool counting = false;
+	size_t allocations = 0;
+	size_t allocated = 0;
+} //namespace
+
+/* Kept out of line, so the compiler doesn't see free() called on memory
+ * that came from operator new.
+ */
+__attribute__((noinline)) void* operator new(size_t size) {
+	if(counting) {
+		++allocations;
+		allocated += size;
+	}
+	if(void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+namespace
+{
+
+/* Ten names to match the ten *_enc channels the dispatcher offers. */
+vector<stringp> encode_messages(int samples) {
+	vector<stringp> out;
+	for(int n = 0 ; n < 10 ; ++n) {
+		flopointpb::FloPointMessage fpm;
+		fpm.set_name(std::to_string(n) + "of09");
+		auto wf = fpm.mutable_waveform();
+		double c = 0.16 + 0.024 * n;
+		for(int i = 0 ; i < samples ; ++i)
+			wf->add_wheight(static_cast<int>(16000 / (1 + std::exp(c*(samples/2-i)))));
+		auto message = make_shared<string>();
+		fpm.SerializeToString(message.get());
+		out.push_back(message);
+	}
+	return out;
+}
+
+/* Subscriber i takes the i'th channel of the mix, round robin.  "enc" stands
+ * for the ten *_enc channels in turn.
+ */
+string channel_for(const vector<string>& mix, size_t i) {
+	const string& pick = mix[i % mix.size()];
+	if(pick == "enc")
+		return std::to_string((i / mix.size()) % 10) + "of09_enc";
+	return pick;
+}
+
+struct result {
+	size_t subscribers;
+	size_t messages;
+	double seconds;
+	size_t allocations;
+	size_t allocated;
+	size_t sent;
+};
+
+/* Bytes read back from the subscribers' connections. */
+size_t drained = 0;
+char scratch[1 << 16];
+
+void drain(const shared_ptr<tcp::socket>& reader) {
+	reader->async_read_some(boost::asio::buffer(scratch),
+			[reader](const boost::system::error_code& ec, size_t n) {
+				drained += n;
+				if(!ec)
+					drain(reader);
+			});
+}
+
+result run(size_t subscribers, const vector<string>& mix,
+		const vector<stringp>& messages, size_t count) {
+	auto service = make_shared<io_service>();
+	context_struct_lite context (service);
+	auto dis = make_shared<dispatcher>(service);
+	dis->build_command_tree();
+
+	tcp::acceptor acceptor (*service,
+			tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+	vector<nsp> subs;
+	vector<shared_ptr<tcp::socket> > readers;
+	for(size_t i = 0 ; i < subscribers ; ++i) {
+		auto reader = make_shared<tcp::socket>(*service);
+		reader->connect(acceptor.local_endpoint());
+		tcp::socket sock (*service);
+		acceptor.accept(sock);
+		auto sub = make_shared<ns>(context_struct(context, dis), sock);
+		drain(reader);
+		readers.push_back(reader);
+
+		string channel = channel_for(mix, i);
+		sentence command = {"subscribe", "to", channel};
+		dis->execute_network_command(command, sub);
+		subs.push_back(sub);
+	}
+
+	port_latency_struct latency;
+	auto deliver = [&](size_t i) {
+		dis->delivery(messages[i % messages.size()],
+				frame_stamp{steady_clock::now(), &latency, 0});
+		service->poll();
+		service->reset();
+	};
+
+	/* Until every subscriber's writes have completed. */
+	auto settle = [&]{
+		for(bool busy = true ; busy ; ) {
+			service->poll();
+			service->reset();
+			busy = false;
+			for(auto& sub : subs)
+				busy = busy || sub->queued() > 0;
+		}
+	};
+
+	/* One pass over every name first, so lazily built state is in place. */
+	for(size_t i = 0 ; i < messages.size() ; ++i)
+		deliver(i);
+	settle();
+
+	result out {subscribers, count, 0, 0, 0, 0};
+	size_t drained_before = drained;
+	allocations = 0;
+	allocated = 0;
+	counting = true;
+	auto start = steady_clock::now();
+	for(size_t i = 0 ; i < count ; ++i)
+		deliver(i);
+	settle();
+	out.seconds = duration<double>(steady_clock::now() - start).count();
+	counting = false;
+	out.allocations = allocations;
+	out.allocated = allocated;
+
+	/* What was written but not yet read back still went out. */
+	service->poll();
+	service->reset();
+	out.sent = drained - drained_before;
+
+	for(auto& reader : readers)
+		reader->close();
+	service->poll();
+	return out;
+}
+
+void report(const result& r) {
+	printf("%6zu subscribers %8zu msgs %11.1f msgs/s %8.1f MB/s %10.1f allocs/msg %12.1f bytes/msg\n",
+			r.subscribers, r.messages,
+			r.seconds > 0 ? r.messages / r.seconds : 0.0,
+			r.seconds > 0 ? r.sent / r.seconds / 1e6 : 0.0,
+			(double)r.allocations / r.messages,
+			(double)r.allocated / r.messages);
+}
+
+/* Ten thousand subscribers need twenty thousand descriptors.  Returns the
+ * limit in force afterwards.
+ */
+size_t raise_descriptor_limit() {
+	struct rlimit lim;
+	if(getrlimit(RLIMIT_NOFILE, &lim) != 0)
+		return 1024;
+	lim.rlim_cur = lim.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &lim);
+	getrlimit(RLIMIT_NOFILE, &lim);
+	return lim.rlim_cur;
+}
+
+} //namespace
+
+
+
+int main(int argc, char** argv) {
+	try {
+		vector<size_t> counts;
+		vector<string> mix;
+		size_t writes;
+		int samples;
+
+		po::options_description desc("Fan-out benchmark options");
+		desc.add_options()
+				("help,h", "Print help messages")
+				("subscribers",
+						po::value<vector<size_t> >(&counts)->multitoken()
+						->default_value({1, 10, 100, 1000, 10000}, "1 10 100 1000 10000"),
+						"Subscriber counts to run")
+				("channels",
+						po::value<vector<string> >(&mix)->multitoken()
+						->default_value({"raw_waveforms", "ascii_waveforms", "protobuf_all", "enc"},
+								"raw_waveforms ascii_waveforms protobuf_all enc"),
+						"Channel mix, handed out to subscribers round robin; enc means *_enc")
+				("writes", po::value<size_t>(&writes)->default_value(1000000),
+						"Subscriber writes per run; the message count follows from it")
+				("samples", po::value<int>(&samples)->default_value(64),
+						"Waveform samples per message");
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		if(vm.count("help")) {
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+
+		size_t descriptors = raise_descriptor_limit();
+		auto messages = encode_messages(samples);
+		printf("channels:");
+		for(auto& each : mix)
+			printf(" %s", each.c_str());
+		printf("  message bytes: %zu\n", messages[0]->size());
+
+		for(auto n : counts) {
+			if(2 * n + 32 > descriptors) {
+				printf("%6zu subscribers skipped, they need %zu descriptors and the limit is %zu\n",
+						n, 2 * n + 32, descriptors);
+				continue;
+			}
+			size_t count = n ? writes / n : writes;
+			report(run(n, mix, messages, count < 100 ? 100 : count));
+		}
+
+	} catch(std::exception& e) {
+		cerr << "Unhandled Exception reached the top of main: "
+				<< e.what() << ", application will now exit" << endl;
+		return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,345 @@
+/* Framer benchmark
+ *
+ * Feeds byte streams of several shapes through serial_session's framer
+ * (check_the_deque, scrub and crc8) and reports throughput together with the
+ * counters the framer kept.  Streams are generated from a fixed seed, so the
+ * counters of two framer implementations can be compared line for line.
+ *
+ * Frames go to a sink instead of the dispatcher.  The session sits on a
+ * pseudo terminal that is never read, so only the bytes handed to
+ * ss::receive are framed.
+ *
+ * Built apart from dewd, from the repository root:
+ *
+ *   g++ -std=gnu++11 -O2 -include fppb/flopointpb.pb.h -Isrc \
+ *     bench/framer_bench.cpp fppb/flopointpb.pb.cc -o framer_bench \
+ *     -lprotobuf -lboost_system -lboost_chrono -lboost_program_options \
+ *     -lboost_filesystem -lpthread
+ */
+
+#define AJS_HACK
+
+#include <ctime>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+#include <fcntl.h>
+
+#include <boost/version.hpp>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include "structs.h"
+#include "types.h"
+#include "utils.h"
+
+#include "network_session.hpp"
+#include "metrics_session.hpp"
+#include "command_graph.hpp"
+
+#include "session.hpp"
+#include "serial_session.hpp"
+
+
+
+using namespace dew;
+namespace po = boost::program_options;
+
+using ::boost::asio::io_service;
+using ::boost::make_iterator_range;
+
+using ::boost::chrono::steady_clock;
+using ::boost::chrono::duration;
+using ::boost::chrono::nanoseconds;
+
+using ::std::string;
+using ::std::vector;
+using ::std::shared_ptr;
+using ::std::make_shared;
+
+using ::std::cout;
+using ::std::cerr;
+using ::std::endl;
+
+namespace
+{
+
+struct options {
+	size_t frames;
+	size_t payload;
+	size_t read_size;
+	u64 seed;
+};
+
+/* A pseudo terminal that nobody reads, opened so that serial_port has a tty
+ * to hold on to.
+ */
+class idle_pty {
+public:
+	idle_pty() : fd_(posix_openpt(O_RDWR | O_NOCTTY)) {
+		if(fd_ < 0 || grantpt(fd_) || unlockpt(fd_))
+			throw std::runtime_error("Unable to open a pseudo terminal.");
+		name_ = ptsname(fd_);
+	}
+	~idle_pty() { close(fd_); }
+
+	const string& name() const { return name_; }
+
+private:
+	int fd_;
+	string name_;
+};
+
+/* One frame as the write test lays it out:
+ *  FF FE nonce1(4) nonce2(4) seq crc8 <payload> reverse(FF FE nonce1)
+ */
+void append_frame(bBuff& out, xoshiro256ss& rng, u8 seq, size_t payload) {
+	size_t start = out.size();
+	out.push_back(0xff);
+	out.push_back(0xfe);
+	u64 bytes = rng();
+	for(int i=8;i;--i) {
+		out.push_back((u8)bytes);
+		bytes >>= 8;
+	}
+	out.push_back(seq);
+	out.push_back(crc8(make_iterator_range(out.begin()+start, out.end())));
+
+	for(size_t i = 0 ; i < payload ; ++i)
+		out.push_back((u8)rng());
+
+	for(int i=5;i>=0;--i)
+		out.push_back(out[start+i]);
+}
+
+size_t frame_overhead() { return 18; }
+
+/* Garbage that is rich in FF so that scrub stops often. */
+void append_garbage(bBuff& out, xoshiro256ss& rng, size_t len) {
+	for(size_t i = 0 ; i < len ; ++i) {
+		u64 draw = rng();
+		out.push_back((draw & 7) == 0 ? 0xff : (u8)(draw >> 8));
+	}
+}
+
+/*-----------------------------------------------------------------------------
+ * One run: the stream is cut into reads, each read is handed to the framer and
+ * the io_service is polled until the framer has nothing left to do.
+ */
+struct result {
+	string shape;
+	size_t bytes = 0;
+	size_t frames = 0;
+	double seconds = 0;
+	string counters;
+};
+
+result run(const string& shape, const bBuff& stream, const vector<size_t>& cuts,
+		const idle_pty& pty) {
+	auto service = make_shared<io_service>();
+	context_struct_lite context (service);
+	auto dis = make_shared<dispatcher>(service);
+	auto framer = make_shared<ss>(context_struct(context, dis), pty.name());
+
+	result out;
+	out.shape = shape;
+	out.bytes = stream.size();
+	framer->set_frame_sink(
+			[&out](stringp, const frame_stamp&) { ++out.frames; });
+
+	/* Reads are copied out ahead of time so the clock only sees the framer. */
+	vector<bBuff> reads;
+	size_t from = 0;
+	for(auto to : cuts) {
+		reads.emplace_back(stream.begin()+from, stream.begin()+to);
+		from = to;
+	}
+
+	auto start = steady_clock::now();
+	for(auto& each : reads) {
+		framer->receive(each, each.size());
+		service->poll();
+		service->reset();
+	}
+	out.seconds = duration<double>(steady_clock::now() - start).count();
+
+	auto& c = framer->get_counts();
+	out.counters =
+			"received=" + std::to_string((int64_t)c.messages_received) +
+			" lost=" + std::to_string((int64_t)c.messages_lost_tot) +
+			" bad_prefix=" + std::to_string((int64_t)c.bad_prefix) +
+			" bad_crc=" + std::to_string((int64_t)c.bad_crc) +
+			" too_long=" + std::to_string((int64_t)c.frame_too_long) +
+			" too_old=" + std::to_string((int64_t)c.frame_too_old) +
+			" garbage=" + std::to_string((int64_t)c.garbage) +
+			" msg_bytes=" + std::to_string((int64_t)c.msg_bytes_tot) +
+			" wrapper_bytes=" + std::to_string((int64_t)c.wrapper_bytes_tot) +
+			" buffered=" + std::to_string(framer->get_buffered());
+	return out;
+}
+
+/* Cuts at every read_size bytes, as a busy serial port would deliver them. */
+vector<size_t> even_cuts(size_t total, size_t read_size) {
+	vector<size_t> cuts;
+	for(size_t at = read_size ; at < total ; at += read_size)
+		cuts.push_back(at);
+	cuts.push_back(total);
+	return cuts;
+}
+
+void report(const result& r) {
+	double mb = r.bytes / 1e6;
+	printf("%-16s %10zu bytes %8zu frames %9.1f MB/s %9.1f ns/frame\n",
+			r.shape.c_str(), r.bytes, r.frames,
+			r.seconds > 0 ? mb / r.seconds : 0.0,
+			r.frames ? r.seconds * 1e9 / r.frames : 0.0);
+	printf("%-16s %s\n", "", r.counters.c_str());
+}
+
+/*-----------------------------------------------------------------------------
+ * The shapes.
+ */
+void clean(const options& opt, const idle_pty& pty) {
+	xoshiro256ss rng (opt.seed);
+	bBuff stream;
+	for(size_t i = 0 ; i < opt.frames ; ++i)
+		append_frame(stream, rng, (u8)(i+1), opt.payload);
+	report(run("clean", stream, even_cuts(stream.size(), opt.read_size), pty));
+}
+
+/* Every frame arrives in two reads, and the split point walks through every
+ * offset of the frame.
+ */
+void split(const options& opt, const idle_pty& pty) {
+	xoshiro256ss rng (opt.seed);
+	bBuff stream;
+	vector<size_t> cuts;
+	size_t length = opt.payload + frame_overhead();
+	for(size_t i = 0 ; i < opt.frames ; ++i) {
+		size_t start = stream.size();
+		append_frame(stream, rng, (u8)(i+1), opt.payload);
+		cuts.push_back(start + 1 + i % (length - 1));
+		cuts.push_back(stream.size());
+	}
+	report(run("split", stream, cuts, pty));
+}
+
+/* Three bytes of garbage for every byte of frame. */
+void garbage(const options& opt, const idle_pty& pty) {
+	xoshiro256ss rng (opt.seed);
+	bBuff stream;
+	for(size_t i = 0 ; i < opt.frames ; ++i) {
+		append_garbage(stream, rng, 3 * (opt.payload + frame_overhead()));
+		append_frame(stream, rng, (u8)(i+1), opt.payload);
+	}
+	report(run("garbage", stream, even_cuts(stream.size(), opt.read_size), pty));
+}
+
+/* Frames as long as the framer accepts. */
+void longest(const options& opt, const idle_pty& pty, size_t max_frame) {
+	xoshiro256ss rng (opt.seed);
+	bBuff stream;
+	size_t count = opt.frames * (opt.payload + frame_overhead()) / max_frame + 1;
+	for(size_t i = 0 ; i < count ; ++i)
+		append_frame(stream, rng, (u8)(i+1), max_frame - frame_overhead());
+	report(run("max_length", stream, even_cuts(stream.size(), opt.read_size), pty));
+}
+
+/* Half of the frames have a broken prefix: either the FE is wrong or the crc
+ * does not match.
+ */
+void corrupt(const options& opt, const idle_pty& pty) {
+	xoshiro256ss rng (opt.seed);
+	bBuff stream;
+	for(size_t i = 0 ; i < opt.frames ; ++i) {
+		size_t start = stream.size();
+		append_frame(stream, rng, (u8)(i+1), opt.payload);
+		switch(i % 4) {
+		case 1: stream[start+1] = 0xfd; break;
+		case 3: stream[start+11] = ~stream[start+11]; break;
+		default: break;
+		}
+	}
+	report(run("corrupt_prefix", stream, even_cuts(stream.size(), opt.read_size), pty));
+}
+
+/* A capture of a real port, e.g. cat /dev/ttyS0 > capture.bin */
+void recorded(const string& path, const options& opt, const idle_pty& pty) {
+	std::ifstream in (path, std::ios::binary);
+	if(!in)
+		throw std::runtime_error("Unable to read " + path);
+	bBuff stream ((std::istreambuf_iterator<char>(in)),
+			std::istreambuf_iterator<char>());
+	report(run(path, stream, even_cuts(stream.size(), opt.read_size), pty));
+}
+
+} //namespace
+
+
+
+int main(int argc, char** argv) {
+	try {
+		options opt;
+		vector<string> captures;
+
+		po::options_description desc("Framer benchmark options");
+		desc.add_options()
+				("help,h", "Print help messages")
+				("frames", po::value<size_t>(&opt.frames)->default_value(200000),
+						"Frames per synthetic stream")
+				("payload", po::value<size_t>(&opt.payload)->default_value(180),
+						"Payload bytes per synthetic frame")
+				("read-size", po::value<size_t>(&opt.read_size)->default_value(4096),
+						"Bytes handed to the framer per read")
+				("seed", po::value<u64>(&opt.seed)->default_value(1),
+						"Seed for the synthetic streams")
+				("recorded", po::value<vector<string> >(&captures)->multitoken(),
+						"Raw captures of a serial port to frame as well");
+
+		po::variables_map vm;
+		po::store(po::parse_command_line(argc, argv, desc), vm);
+		if(vm.count("help")) {
+			cout << desc << endl;
+			return 0;
+		}
+		po::notify(vm);
+
+		if(opt.payload < 1 || opt.read_size < 1)
+			throw std::runtime_error("Payload and read size must be positive.");
+
+		idle_pty pty;
+
+		/* Ask a session rather than repeat its limit here. */
+		size_t max_frame;
+		{
+			auto service = make_shared<io_service>();
+			context_struct_lite context (service);
+			auto dis = make_shared<dispatcher>(service);
+			max_frame = ss(context_struct(context, dis), pty.name()).get_max_frame_length();
+		}
+
+		clean(opt, pty);
+		split(opt, pty);
+		garbage(opt, pty);
+		longest(opt, pty, max_frame);
+		corrupt(opt, pty);
+		for(auto& path : captures)
+			recorded(path, opt, pty);
+
+	} catch(std::exception& e) {
+		cerr << "Unhandled Exception reached the top of main: "
+				<< e.what() << ", application will now exit" << endl;
+		return 2;
+	}
+
+	return 0;
+}
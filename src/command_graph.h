@@ -11,13 +11,21 @@
 
 namespace dew {
 
+/* October 18, 2026
+ *
+ * Children are held in a flat vector sorted by key.  Command tables are small
+ * and built once, so a binary search over contiguous keys beats a map lookup
+ * and lets us resolve a word without building a string from it.
+ */
+typedef vector<pair<string,nodep> > child_table;
+
 class node : public enable_shared_from_this<node> {
 public:
 	node(){}
-	node(map<string,nodep> children_in) : children(children_in) {}
+	node(map<string,nodep> children_in) : children(children_in.begin(),children_in.end()) {}
 	node(node_fn fn_in) : fn(fn_in) {}
 	node(map<string,nodep> children_in, node_fn fn_in) :
-		children(children_in), fn(fn_in) {}
+		children(children_in.begin(),children_in.end()), fn(fn_in) {}
 
 	void spawn(pair<string,nodep>);
 	void spawn(string, nodep);
@@ -25,21 +33,22 @@ public:
 	void purge();
 
 	void set_fn(std::function<void(nsp)> fn_in) { fn = fn_in; }
-	const shared_ptr<node>& child(const string & key) const { return children.at(key); }
-	map<string,nodep>::const_iterator get_child(string& key) const{ return children.find(key); }
-	map<string,nodep>::const_iterator get_end() const{ return children.cend(); }
+	void set_args(arg_fn args_in) { args = args_in; }
+	const node* get_child(word) const;
 	string descendants(const int) const;
 
 	void operator()(nsp) const;
+	void operator()(nsp, arguments) const;
 
 	void own() { owned = true; }
 	bool is_owned() { return owned; }
-	bool is_leaf() { return children.empty(); }
+	bool is_leaf() const { return children.empty(); }
 
 
 private:
-	map<string,nodep> children;
+	child_table children;
 	node_fn fn;
+	arg_fn args;
 	bool owned = false;
 };
 
@@ -63,12 +63,18 @@ using ::std::make_pair;
 
 using ::std::search;
 using ::std::find;
+using ::std::lower_bound;
 using ::std::copy;
 using ::std::reverse_copy;
 
 
+/* Like map::insert, an existing key is left untouched. */
 void node::spawn(pair<string,nodep> child) {
-	children.insert(child);
+	auto pos = lower_bound(children.begin(), children.end(), child,
+			[](const pair<string,nodep>& a, const pair<string,nodep>& b)
+			{ return a.first < b.first; });
+	if(pos == children.end() || pos->first != child.first)
+		children.insert(pos, child);
 }
 void node::spawn(string str_in, nodep node_in) {
 	spawn(make_pair(str_in, node_in));
@@ -90,6 +96,14 @@ void node::purge() {
 	}
 }
 
+const node* node::get_child(word key) const {
+	auto pos = lower_bound(children.begin(), children.end(), key,
+			[](const pair<string,nodep>& a, word b) { return word(a.first) < b; });
+	if(pos == children.end() || word(pos->first) != key)
+		return nullptr;
+	return pos->second.get();
+}
+
 string node::descendants(const int ancestors) const {
 	string d;
 
@@ -111,6 +125,14 @@ void node::operator()(nsp in) const {
 	}
 }
 
+/* Nodes that take arguments are handed the words left after the match. */
+void node::operator()(nsp in, arguments rest) const {
+	if(args)
+		args(in, rest);
+	else
+		(*this)(in);
+}
+
 } // dew namespace
 
 
@@ -4,6 +4,7 @@
  */
 
 #define AJS_HACK
+//#define DEWD_TRACING
 
 #include <ctime>
 #include <iostream>
@@ -25,6 +26,7 @@
 #include "utils.h"
 
 #include "network_session.hpp"
+#include "metrics_session.hpp"
 #include "command_graph.hpp"
 
 #include "session.hpp"
@@ -78,6 +80,13 @@ int main(int argc, char** argv) {
 		vector<string> wdev;
 		string conf;
 		unsigned short timeout;
+		unsigned short sample_interval;
+		unsigned short metrics_port;
+		bool features = false;
+		size_t history_size;
+		unsigned history_age;
+		bool persist_history = false;
+		unsigned history_slot;
 		write_test_struct wts;
 
 
@@ -91,6 +100,12 @@ int main(int argc, char** argv) {
 			("timeout",po::value<unsigned short>(&timeout)->default_value(100),
 				"Used with poll-read serial port interface to set polling rate."
 				"Value is in milliseconds.")
+			("sample-interval",
+				po::value<unsigned short>(&sample_interval)->default_value(1000),
+				"Interval at which each serial port's UART counters are sampled in the"
+				" background.  Queries are answered from the latest sample and rates"
+				" are computed between samples.  Set to 0 to read the counters on"
+				" every query instead.  Value is in milliseconds.")
 			("read-write", po::value<vector<string> >(&rwdev)->multitoken(),
 				"Serial ports open in read-write mode, which reads at the standard asio"
 				" async-read-some rate and writes full commands.")
@@ -113,11 +128,46 @@ int main(int argc, char** argv) {
 				"The maximum value of the c parameter used to generate mock waveforms.")
 			("sample_size", po::value<int>(&wts.sample_size)->default_value(100),
 				"The number of mock waveforms generated before a sample repeats.  Set"
-				" to 0 for waveforms generated by rand(), instead.")
+				" to 0 for randomly generated waveforms, instead.")
 			("peak", po::value<double>(&wts.peak)->default_value(65000),
 				"The peak waveform value.  Note that this number is strictly greater"
 				" than all values of a mock waveform.")
 			;
+		po::options_description load("Load generator options.  These shape the"
+			" frames written to ports opened in a test mode");
+		load.add_options()
+			("rate", po::value<double>(&wts.rate)->default_value(0),
+				"Target frames per second written to each test port.  Set to 0 to"
+				" write as fast as the port accepts data.")
+			("burst", po::value<int>(&wts.burst)->default_value(1),
+				"Frames written back to back on each tick of a paced test port.")
+			("min_samples", po::value<int>(&wts.min_samples)->default_value(64),
+				"The minimum number of samples in a mock waveform.")
+			("max_samples", po::value<int>(&wts.max_samples)->default_value(64),
+				"The maximum number of samples in a mock waveform.  Sample counts are"
+				" drawn uniformly between min_samples and max_samples.")
+			("names", po::value<vector<string> >(&wts.names)->multitoken(),
+				"Message names to draw from, each optionally weighted as name:weight."
+				"  Default is 0of09 through 9of09 with equal weight.")
+			("p_bad_crc", po::value<double>(&wts.p_bad_crc)->default_value(0),
+				"Probability that a frame is written with a bad prefix crc.")
+			("p_bad_prefix", po::value<double>(&wts.p_bad_prefix)->default_value(0),
+				"Probability that a frame is followed by a false FF prefix.")
+			("p_truncated", po::value<double>(&wts.p_truncated)->default_value(0),
+				"Probability that a frame is cut short and never terminated.")
+			("p_garbage", po::value<double>(&wts.p_garbage)->default_value(0),
+				"Probability that a frame is followed by random non-FF bytes.")
+			("p_lost", po::value<double>(&wts.p_lost)->default_value(0),
+				"Probability that a sequence number is skipped before a frame.")
+			("seed", po::value<unsigned long long>(&wts.seed)->default_value(0),
+				"Seed for the per-port random generators.  Each port mixes in its own"
+				" device name, so a fixed seed reproduces every port's output.  Set"
+				" to 0 to seed from the clock.")
+			("raw_payload", po::bool_switch(&wts.raw_payload),
+				"Write each waveform as a raw record of little endian samples, in"
+				" the narrowest width that holds them, instead of a protobuf"
+				" FloPointMessage.")
+			;
 		po::options_description general("General options");
 		general.add_options()
 			("help,h", "Print help messages.")
@@ -129,10 +179,29 @@ int main(int argc, char** argv) {
 				" write to the given directory.")
 			("config,c",po::value<string>(&conf)->default_value(
 				"/usr/local/etc/dewd/dewd.conf"), "Specify a configuration file.")
+			("metrics-port", po::value<unsigned short>(&metrics_port)->default_value(0),
+				"Serve Prometheus metrics over HTTP at /metrics on this port.  The page"
+				" is rebuilt once per sample-interval.  Set to 0 to disable.")
+			("features", po::bool_switch(&features),
+				"Compute peak, argmax, integral, baseline and rise time of every"
+				" waveform and store them with the message.  Without it they are"
+				" computed only while the features channel has subscribers.")
+			("history-size", po::value<size_t>(&history_size)->default_value(10000),
+				"Keep at least this many of the latest messages in the history.  Up"
+				" to 255 more are held, since old messages are dropped in chunks.")
+			("history-age", po::value<unsigned>(&history_age)->default_value(0),
+				"Also drop history older than this many seconds.  Set to 0 to keep"
+				" messages regardless of age.")
+			("persist-history", po::bool_switch(&persist_history),
+				"Mirror the history into dewd.history in the logging directory and"
+				" reload it on start.  The file holds history-size messages.")
+			("history-slot", po::value<unsigned>(&history_slot)->default_value(2048),
+				"Bytes set aside per message in the history file.  Larger messages"
+				" are kept in memory only.")
 			;
 
 		po::options_description cmdline_options;
-		cmdline_options.add(ifaces).add(mock).add(general);
+		cmdline_options.add(ifaces).add(mock).add(load).add(general);
 
 
 		po::variables_map vmap;
@@ -148,6 +217,20 @@ int main(int argc, char** argv) {
 			}
 
 			po::notify(vmap);
+
+			/* A mix with no positive weight has no name to draw. */
+			double total = 0;
+			for(auto& entry : wts.names) {
+				string name;
+				double weight;
+				if(!parse_name_weight(entry, name, weight) || name.empty()
+						|| !(weight >= 0) || std::isinf(weight))
+					throw po::error("--names entry '" + entry + "' is not name or"
+							" name:weight with a weight of 0 or more");
+				total += weight;
+			}
+			if(!wts.names.empty() && !(total > 0))
+				throw po::error("--names needs a name with a weight above 0");
 		}
 		catch(po::error& poe) {
 
@@ -158,6 +241,17 @@ int main(int argc, char** argv) {
 
 		auto service = make_shared<io_service>();
 		auto dis = make_shared<dispatcher>(service, logging_directory, wts);
+		dis->set_sample_interval(boost::chrono::milliseconds(sample_interval));
+		dis->set_features(features);
+		dis->set_history(history_size, history_age * 1000000LL);
+		if(persist_history) {
+			try {
+				dis->persist_history(history_size, history_slot);
+			}
+			catch(std::exception& e) {
+				cerr << "History is not persisted: " << e.what() << ".\n";
+			}
+		}
 
 		for(auto it : rdev)
 			dis->make_r_ss(it,timeout);
@@ -174,6 +268,11 @@ int main(int argc, char** argv) {
 		tcp::endpoint ep (tcp::v4(),port);
 		dis->make_ns(ep);
 
+		if(metrics_port) {
+			tcp::endpoint mep (tcp::v4(),metrics_port);
+			dis->make_ms(mep);
+		}
+
 		dis->build_command_tree();
 
 		/*
@@ -0,0 +1,134 @@
+/*
+ * histogram.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <boost/chrono.hpp>
+#include <boost/chrono/time_point.hpp>
+
+
+namespace dew {
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Log-linear latency histogram in the style of HdrHistogram.  Values below 32
+ * get a bucket each.  Above that every power of two is split into 16 equal
+ * buckets, so any recorded value is reported to within 1/16 of itself.  That
+ * covers the whole range of a u64 in under a thousand buckets.
+ *
+ * Recording is a count-leading-zeros, a shift and an increment, cheap enough
+ * to leave on everywhere.  A histogram is only touched from its owner's io
+ * thread, so the buckets are plain integers.
+ */
+
+class latency_histogram {
+public:
+	latency_histogram() { reset(); }
+
+	void record(uint64_t value) {
+		++buckets_[index_of(value)];
+		++count_;
+		sum_ += value;
+		if(value > max_)
+			max_ = value;
+	}
+
+	void record(boost::chrono::steady_clock::time_point from,
+			boost::chrono::steady_clock::time_point to) {
+		auto ns = boost::chrono::duration_cast<boost::chrono::nanoseconds>(to - from);
+		record(ns.count() > 0 ? ns.count() : 0);
+	}
+
+	void reset() {
+		std::memset(buckets_, 0, sizeof(buckets_));
+		count_ = 0;
+		sum_ = 0;
+		max_ = 0;
+	}
+
+	uint64_t count() const { return count_; }
+	uint64_t sum() const { return sum_; }
+	uint64_t max() const { return max_; }
+
+	/* The largest value that shares a bucket with the q'th quantile. */
+	uint64_t quantile(double q) const {
+		if(count_ == 0)
+			return 0;
+		uint64_t rank = static_cast<uint64_t>(q * count_);
+		if(rank >= count_)
+			rank = count_ - 1;
+		uint64_t seen = 0;
+		for(int i = 0 ; i < BUCKETS ; ++i) {
+			seen += buckets_[i];
+			if(seen > rank)
+				return highest_in(i) < max_ ? highest_in(i) : max_;
+		}
+		return max_;
+	}
+
+	/* {"count":n,"p50":x,"p99":x,"p999":x,"max":x} in the recorded unit. */
+	void append_json(std::string& out) const {
+		out += "{\"count\":";
+		out += std::to_string(count_);
+		out += ",\"p50\":";
+		out += std::to_string(quantile(0.5));
+		out += ",\"p99\":";
+		out += std::to_string(quantile(0.99));
+		out += ",\"p999\":";
+		out += std::to_string(quantile(0.999));
+		out += ",\"max\":";
+		out += std::to_string(max_);
+		out += '}';
+	}
+
+	/* Buckets are exposed so that exporters can render cumulative counts. */
+	static const int SUB_BITS = 5;
+	static const int SUB = 1 << SUB_BITS;
+	static const int HALF = SUB / 2;
+	static const int BUCKETS = (64 - SUB_BITS + 1) * HALF + HALF;
+
+	uint64_t bucket(int i) const { return buckets_[i]; }
+
+	/* Number of recorded values whose bucket lies entirely at or below le. */
+	uint64_t count_at_or_below(uint64_t le) const {
+		uint64_t seen = 0;
+		for(int i = 0 ; i < BUCKETS && highest_in(i) <= le ; ++i)
+			seen += buckets_[i];
+		return seen;
+	}
+
+	static int index_of(uint64_t value) {
+		if(value < SUB)
+			return static_cast<int>(value);
+		int shift = 63 - __builtin_clzll(value) - (SUB_BITS - 1);
+		return shift * HALF + static_cast<int>(value >> shift);
+	}
+
+	static uint64_t highest_in(int index) {
+		if(index < SUB)
+			return index;
+		int shift = index / HALF - 1;
+		uint64_t mantissa = index % HALF + HALF;
+		return ((mantissa + 1) << shift) - 1;
+	}
+
+private:
+	uint64_t buckets_[BUCKETS];
+	uint64_t count_;
+	uint64_t sum_;
+	uint64_t max_;
+};
+
+} //namespace dew
+
+#endif /* HISTOGRAM_H_ */
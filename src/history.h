@@ -0,0 +1,218 @@
+/*
+ * history.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <cstdint>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "waveform_features.h"
+
+
+namespace dew {
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Columnar message history.  Messages are appended to fixed size chunks, one
+ * vector per field, so a query over times or names walks contiguous memory
+ * and a message's samples are one contiguous block of int32.  Names are
+ * interned once and stored as small ids.
+ *
+ * Every message gets the next history sequence number, and times never go
+ * backwards: a timestamp older than the last one stored is raised to it.  A
+ * time query is then a binary search over chunks followed by one inside the
+ * chunk.  A store reloaded from disk may skip numbers; a chunk only ever
+ * holds consecutive ones, so a skip starts a new chunk and a sequence query
+ * is a binary search too.
+ *
+ * Retention drops whole chunks from the front, once doing so still leaves at
+ * least max_messages, or once every message in the chunk is older than
+ * max_age.  A max_age of zero keeps messages regardless of age.
+ *
+ * The blob is the message as it arrived when that was a protobuf, and null
+ * for a raw record.
+ *
+ * The store is only touched from the io thread.
+ */
+
+class history_store {
+public:
+	typedef std::shared_ptr<std::string> blob_ptr;
+
+	struct chunk {
+		uint64_t first_seq;
+		std::vector<int64_t> time;      /* microseconds since the Unix epoch */
+		std::vector<uint16_t> port;
+		std::vector<uint32_t> name;
+		std::vector<uint32_t> offset;   /* where each message's samples begin */
+		std::vector<int32_t> samples;
+		std::vector<blob_ptr> blob;
+		std::vector<waveform_features> features;
+
+		size_t size() const { return time.size(); }
+		uint64_t seq(size_t i) const { return first_seq + i; }
+		const int32_t* samples_of(size_t i) const { return samples.data() + offset[i]; }
+		size_t samples_in(size_t i) const {
+			return (i + 1 < offset.size() ? offset[i+1] : samples.size()) - offset[i];
+		}
+	};
+
+	history_store(size_t max_messages = 10000, int64_t max_age_us = 0,
+			size_t chunk_size = 256) :
+		max_messages_(max_messages), max_age_us_(max_age_us),
+		chunk_size_(chunk_size ? chunk_size : 1) {}
+
+	void set_limits(size_t max_messages, int64_t max_age_us) {
+		max_messages_ = max_messages;
+		max_age_us_ = max_age_us;
+	}
+
+	uint64_t append(int64_t time_us, uint16_t port, const std::string& name,
+			const int32_t* samples, size_t n, const blob_ptr& blob,
+			const waveform_features& features) {
+		return append_at(next_seq_, time_us, port, name, samples, n, blob, features);
+	}
+
+	/* The same, numbered seq, for a store reloaded from disk.  Numbers below
+	 * next_seq() are taken as next_seq().
+	 */
+	uint64_t append_at(uint64_t seq, int64_t time_us, uint16_t port,
+			const std::string& name, const int32_t* samples, size_t n,
+			const blob_ptr& blob, const waveform_features& features) {
+		if(time_us < last_time_)
+			time_us = last_time_;
+		last_time_ = time_us;
+
+		bool skip = seq > next_seq_;
+		if(skip)
+			next_seq_ = seq;
+		if(chunks_.empty() || skip || chunks_.back()->size() >= chunk_size_) {
+			chunks_.emplace_back(new chunk);
+			chunk& fresh = *chunks_.back();
+			fresh.first_seq = next_seq_;
+			fresh.time.reserve(chunk_size_);
+			fresh.port.reserve(chunk_size_);
+			fresh.name.reserve(chunk_size_);
+			fresh.offset.reserve(chunk_size_);
+			fresh.blob.reserve(chunk_size_);
+			fresh.features.reserve(chunk_size_);
+		}
+
+		chunk& c = *chunks_.back();
+		c.time.push_back(time_us);
+		c.port.push_back(port);
+		c.name.push_back(intern(name));
+		c.offset.push_back(c.samples.size());
+		c.samples.insert(c.samples.end(), samples, samples + n);
+		c.blob.push_back(blob);
+		c.features.push_back(features);
+		++count_;
+
+		expire(time_us);
+		return next_seq_++;
+	}
+
+	size_t size() const { return count_; }
+	uint64_t first_seq() const { return chunks_.empty() ? next_seq_ : chunks_.front()->first_seq; }
+	uint64_t next_seq() const { return next_seq_; }
+
+	uint32_t intern(const std::string& name) {
+		auto found = ids_.find(name);
+		if(found != ids_.end())
+			return found->second;
+		names_.push_back(name);
+		return ids_[name] = names_.size() - 1;
+	}
+	bool find_name(const std::string& name, uint32_t& id) const {
+		auto found = ids_.find(name);
+		if(found == ids_.end())
+			return false;
+		id = found->second;
+		return true;
+	}
+	const std::string& name_of(uint32_t id) const { return names_[id]; }
+
+	/* fn(const chunk&, size_t) for every stored message, oldest first. */
+	template<typename Fn>
+	void for_each(Fn fn) const {
+		for(auto& c : chunks_)
+			for(size_t i = 0 ; i < c->size() ; ++i)
+				fn(*c, i);
+	}
+
+	/* The same, starting with the first message stored at or after time_us. */
+	template<typename Fn>
+	void for_each_since(int64_t time_us, Fn fn) const {
+		auto c = std::lower_bound(chunks_.begin(), chunks_.end(), time_us,
+				[](const std::unique_ptr<chunk>& a, int64_t t) { return a->time.back() < t; });
+		if(c == chunks_.end())
+			return;
+		size_t i = std::lower_bound((*c)->time.begin(), (*c)->time.end(), time_us)
+				- (*c)->time.begin();
+		visit(c, i, fn);
+	}
+
+	/* The same, starting with sequence number seq or the oldest still held. */
+	template<typename Fn>
+	void for_each_from(uint64_t seq, Fn fn) const {
+		if(chunks_.empty() || seq >= next_seq_)
+			return;
+		auto c = std::upper_bound(chunks_.begin(), chunks_.end(), seq,
+				[](uint64_t s, const std::unique_ptr<chunk>& a) { return s < a->first_seq; });
+		if(c == chunks_.begin()) {
+			visit(c, 0, fn);
+			return;
+		}
+		--c;
+		visit(c, seq - (*c)->first_seq, fn);
+	}
+
+private:
+	typedef std::deque<std::unique_ptr<chunk> > chunk_list;
+
+	size_t max_messages_;
+	int64_t max_age_us_;
+	size_t chunk_size_;
+
+	chunk_list chunks_;
+	size_t count_ = 0;
+	uint64_t next_seq_ = 0;
+	int64_t last_time_ = 0;
+
+	std::unordered_map<std::string, uint32_t> ids_;
+	std::vector<std::string> names_;
+
+	template<typename Fn>
+	void visit(chunk_list::const_iterator c, size_t i, Fn& fn) const {
+		for( ; c != chunks_.end() ; ++c, i = 0)
+			for( ; i < (*c)->size() ; ++i)
+				fn(**c, i);
+	}
+
+	void expire(int64_t now_us) {
+		while(chunks_.size() > 1) {
+			const chunk& front = *chunks_.front();
+			bool over = count_ - front.size() >= max_messages_;
+			bool stale = max_age_us_ > 0 && front.time.back() < now_us - max_age_us_;
+			if(!over && !stale)
+				break;
+			count_ -= front.size();
+			chunks_.pop_front();
+		}
+	}
+};
+
+} // dew namespace
+
+#endif /* HISTORY_H_ */
@@ -0,0 +1,252 @@
+/*
+ * history_file.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef HISTORY_FILE_H_
+#define HISTORY_FILE_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <boost/crc.hpp>
+
+#include "waveform_features.h"
+#include "history.h"
+
+
+namespace dew {
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * The history, mirrored into a fixed size circular file mapped into memory.
+ *
+ * The file is one header page followed by slot_count slots of slot_size
+ * bytes.  The header only describes the geometry.  It is written once, when
+ * the file is created, and carries its own crc, so a file whose header does
+ * not check out, or whose geometry differs from what was asked for, is
+ * started over.
+ *
+ * Message n, numbered as in the history store, goes to slot n % slot_count
+ * and keeps its number there.  A slot holds seq + 1, so zero marks an empty
+ * one.  A slot is written by clearing its seq, filling in the record, then
+ * its crc, then its seq, so a slot whose crc doesn't match what it holds was
+ * caught part way and is ignored.  Loading is a scan of the slots, a sort by
+ * seq and a copy of each record into the history store under its own number.
+ * Nothing is parsed.
+ *
+ * A record that doesn't fit in a slot is not persisted.  Its slot is still
+ * cleared, so the file never holds a record older than the last slot_count,
+ * and its number is missing from the store once reloaded.  A message that
+ * arrived as a raw record has no blob, and is loaded back without one.
+ *
+ * Port ids only hold for the run that handed them out, so a slot keeps the
+ * port's name.  Loading asks the caller for the id that name has now.
+ */
+
+class history_file {
+public:
+	history_file(const std::string& path, uint32_t slot_count, uint32_t slot_size) :
+		path_(path)
+	{
+		if(slot_count == 0 || slot_size < sizeof(slot_head))
+			throw std::runtime_error("history file geometry is too small");
+
+		fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if(fd_ < 0)
+			throw std::runtime_error("cannot open " + path + ": " + strerror(errno));
+
+		size_ = HEADER + uint64_t(slot_count) * slot_size;
+		struct stat st;
+		bool reuse = fstat(fd_, &st) == 0 && uint64_t(st.st_size) == size_;
+		if(!reuse && (ftruncate(fd_, 0) != 0 || ftruncate(fd_, size_) != 0)) {
+			::close(fd_);
+			throw std::runtime_error("cannot size " + path + ": " + strerror(errno));
+		}
+
+		void* base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+		if(base == MAP_FAILED) {
+			::close(fd_);
+			throw std::runtime_error("cannot map " + path + ": " + strerror(errno));
+		}
+		base_ = static_cast<char*>(base);
+
+		file_head wanted = make_head(slot_count, slot_size);
+		if(!reuse || std::memcmp(base_, &wanted, sizeof(wanted)) != 0) {
+			std::memset(base_, 0, size_);
+			std::memcpy(base_, &wanted, sizeof(wanted));
+			msync(base_, HEADER, MS_SYNC);
+		}
+		head_ = wanted;
+	}
+
+	~history_file() {
+		munmap(base_, size_);
+		::close(fd_);
+	}
+
+	history_file(const history_file&) = delete;
+	history_file& operator=(const history_file&) = delete;
+
+	/* Copies every intact record into the store, oldest first, each under
+	 * the number it had when it was appended.  port_id(name) gives the id of
+	 * the port named in a record.  Returns the number loaded.
+	 */
+	template<typename PortId>
+	size_t load(history_store& store, PortId port_id) {
+		std::vector<std::pair<uint64_t, uint32_t> > found;
+		for(uint32_t i = 0 ; i < head_.slot_count ; ++i) {
+			slot_head s;
+			std::memcpy(&s, slot(i), sizeof(s));
+			if(s.seq && intact(slot(i), s))
+				found.emplace_back(s.seq, i);
+		}
+		std::sort(found.begin(), found.end());
+
+		for(auto& each : found) {
+			const char* at = slot(each.second);
+			slot_head s;
+			std::memcpy(&s, at, sizeof(s));
+			const char* body = at + sizeof(s);
+			std::string name (body, s.name_length);
+			body += s.name_length;
+			std::string port (body, s.port_length);
+			body += s.port_length;
+			std::vector<int32_t> samples (s.sample_count);
+			std::memcpy(samples.data(), body, 4 * s.sample_count);
+			body += 4 * s.sample_count;
+			history_store::blob_ptr blob;
+			if(s.blob_length)
+				blob = std::make_shared<std::string>(body, s.blob_length);
+			store.append_at(each.first - 1, s.time_us, port_id(port), name,
+					samples.data(), samples.size(), blob, s.features);
+		}
+		return found.size();
+	}
+
+	/* Writes message seq of the history store.  False when the record is too
+	 * large for a slot.
+	 */
+	bool append(uint64_t seq, int64_t time_us, const std::string& port,
+			const std::string& name, const int32_t* samples, size_t n,
+			const std::string& blob, const waveform_features& features) {
+		size_t body = name.size() + port.size() + 4 * n + blob.size();
+		char* at = slot(seq % head_.slot_count);
+		__atomic_store_n(reinterpret_cast<uint64_t*>(at), 0, __ATOMIC_RELEASE);
+		if(sizeof(slot_head) + body > head_.slot_size || name.size() > 0xffff
+				|| port.size() > 0xffff) {
+			++skipped_;
+			return false;
+		}
+
+		slot_head s {};
+
+		s.time_us = time_us;
+		s.port_length = port.size();
+		s.name_length = name.size();
+		s.sample_count = n;
+		s.blob_length = blob.size();
+		s.features = features;
+		char* out = at + sizeof(s);
+		std::memcpy(out, name.data(), name.size());
+		std::memcpy(out + name.size(), port.data(), port.size());
+		std::memcpy(out + name.size() + port.size(), samples, 4 * n);
+		std::memcpy(out + name.size() + port.size() + 4 * n, blob.data(), blob.size());
+		s.length = body;
+		s.seq = seq + 1;
+		s.crc = checksum(s, out);
+		std::memcpy(at + sizeof(s.seq), reinterpret_cast<char*>(&s) + sizeof(s.seq),
+				sizeof(s) - sizeof(s.seq));
+
+		/* The seq goes in last; once it's there the slot is whole. */
+		__atomic_store_n(reinterpret_cast<uint64_t*>(at), s.seq, __ATOMIC_RELEASE);
+		return true;
+	}
+
+	const std::string& path() const { return path_; }
+	uint64_t skipped() const { return skipped_; }
+
+private:
+	static const uint64_t HEADER = 4096;
+	static const uint64_t MAGIC = 0x3153494844574544ULL; /* "DEWDHIS1" */
+
+	struct file_head {
+		uint64_t magic;
+		uint32_t version;
+		uint32_t slot_head_size;
+		uint32_t slot_count;
+		uint32_t slot_size;
+		uint32_t crc;
+		uint32_t reserved;
+	};
+
+	struct slot_head {
+		uint64_t seq;
+		uint32_t crc;
+		uint32_t length;
+		int64_t time_us;
+		uint16_t port_length;
+		uint16_t name_length;
+		uint32_t sample_count;
+		uint32_t blob_length;
+		uint32_t reserved;
+		waveform_features features;
+	};
+
+	std::string path_;
+	int fd_ = -1;
+	char* base_ = nullptr;
+	uint64_t size_ = 0;
+	file_head head_ {};
+	uint64_t skipped_ = 0;
+
+	char* slot(uint64_t i) const { return base_ + HEADER + i * head_.slot_size; }
+
+	static file_head make_head(uint32_t slot_count, uint32_t slot_size) {
+		/* Version 1 slots numbered their records on their own, and version
+		 * 2 slots held port ids.
+		 */
+		file_head h {MAGIC, 3, sizeof(slot_head), slot_count, slot_size, 0, 0};
+		boost::crc_32_type crc;
+		crc.process_bytes(&h, sizeof(h));
+		h.crc = crc.checksum();
+		return h;
+	}
+
+	/* Covers the seq and everything after the crc, body included. */
+	static uint32_t checksum(const slot_head& s, const char* body) {
+		boost::crc_32_type crc;
+		crc.process_bytes(&s.seq, sizeof(s.seq));
+		crc.process_bytes(&s.length, sizeof(s) - offsetof(slot_head, length));
+		crc.process_bytes(body, s.length);
+		return crc.checksum();
+	}
+
+	bool intact(const char* at, const slot_head& s) const {
+		if(sizeof(s) + uint64_t(s.length) > head_.slot_size)
+			return false;
+		if(s.length != uint64_t(s.name_length) + s.port_length + 4ULL * s.sample_count
+				+ s.blob_length)
+			return false;
+		return checksum(s, at + sizeof(s)) == s.crc;
+	}
+};
+
+} // dew namespace
+
+#endif /* HISTORY_FILE_H_ */
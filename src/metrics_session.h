@@ -0,0 +1,66 @@
+/*
+ * metrics_session.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef METRICS_SESSION_H_
+#define METRICS_SESSION_H_
+
+namespace dew {
+
+using ::boost::asio::io_service;
+using ::boost::asio::ip::tcp;
+using ::boost::asio::streambuf;
+
+using ::std::string;
+using ::std::move;
+
+using ::std::enable_shared_from_this;
+
+/*=============================================================================
+ * October 18, 2026 :: metrics_session class
+ *
+ * A minimal HTTP/1.0 listener for Prometheus.  GET /metrics is answered with
+ * the page the dispatcher last rendered, so a scrape costs one write of a
+ * shared buffer no matter how many ports and channels there are.  Every
+ * response closes the connection.
+ */
+class metrics_session : public enable_shared_from_this<metrics_session> {
+public:
+	metrics_session(
+			context_struct context_in,
+			tcp::endpoint const& ep_in
+	);
+
+	metrics_session(
+			context_struct context_in,
+			tcp::socket& sock_in
+	);
+
+	msp get_ms();
+
+	void start_accept() { if(acceptor_.is_open()) do_accept(); }
+	void start_read() { if(socket_.is_open()) do_read(); }
+
+private:
+	context_struct context_;
+	tcp::acceptor acceptor_;
+	tcp::socket socket_;
+
+	const size_t MAX_REQUEST = 8192;
+	streambuf request_ {MAX_REQUEST};
+	stringp header_;
+	stringp body_;
+
+	void do_accept();
+	void do_read();
+	void handle_read(const boost::system::error_code&, size_t);
+	void do_respond(const string&, stringp);
+	void handle_write(const boost::system::error_code&, size_t);
+};
+
+} // dew namespace
+
+#endif /* METRICS_SESSION_H_ */
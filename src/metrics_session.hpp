@@ -0,0 +1,133 @@
+/*
+ * metrics_session.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef METRICS_SESSION_HPP_
+#define METRICS_SESSION_HPP_
+
+#include <iostream>
+#include <string>
+#include <istream>
+#include <vector>
+
+#include <memory>
+#include <utility>
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+
+#include "structs.h"
+#include "types.h"
+#include "utils.h"
+
+#include "metrics_session.h"
+#include "session.h"
+
+
+namespace dew {
+
+using ::boost::asio::io_service;
+using ::boost::asio::ip::tcp;
+using ::boost::bind;
+using ::boost::system::error_code;
+
+using ::std::istream;
+using ::std::string;
+using ::std::vector;
+
+using ::std::make_shared;
+using ::std::shared_ptr;
+
+/* October 18, 2026 :: constructors */
+
+metrics_session::metrics_session(
+		context_struct context_in,
+		tcp::endpoint const& ep_in
+) :
+		context_(context_in),
+		acceptor_(*context_.service, ep_in),
+		socket_(*context_.service)
+{
+}
+
+metrics_session::metrics_session(
+		context_struct context_in,
+		tcp::socket& sock_in
+) :
+		context_(context_in),
+		acceptor_(*context_.service),
+		socket_(move(sock_in))
+{
+}
+
+msp metrics_session::get_ms() {
+	return shared_from_this();
+}
+
+void metrics_session::do_accept() {
+	auto self (shared_from_this());
+	acceptor_.async_accept(socket_,
+			[this,self](error_code ec)
+			{
+				if(!ec) {
+					context_.dispatch->make_ms(socket_);
+				}
+				start_accept();
+			});
+}
+
+void metrics_session::do_read() {
+	auto self (shared_from_this());
+	boost::asio::async_read_until(socket_, request_, "\r\n\r\n",
+			bind(&metrics_session::handle_read, self, _1, _2));
+}
+
+/* Only the request line matters.  Headers are read and ignored. */
+void metrics_session::handle_read(const error_code& ec, size_t len) {
+	if(ec) {
+		if(ec == boost::asio::error::not_found)
+			do_respond("413 Request Entity Too Large", make_shared<string>());
+		else
+			context_.dispatch->remove_ms(shared_from_this());
+		return;
+	}
+
+	istream is (&request_);
+	string method, target;
+	is >> method >> target;
+
+	if(method != "GET")
+		do_respond("405 Method Not Allowed", make_shared<string>());
+	else if(target != "/metrics")
+		do_respond("404 Not Found", make_shared<string>());
+	else
+		do_respond("200 OK", context_.dispatch->get_metrics_page());
+}
+
+void metrics_session::do_respond(const string& status, stringp body) {
+	auto self (shared_from_this());
+	body_ = body;
+	header_ = make_shared<string>("HTTP/1.0 " + status + "\r\n");
+	*header_ += "Content-Type: text/plain; version=0.0.4\r\n";
+	*header_ += "Content-Length: " + to_string(body_->size()) + "\r\n";
+	*header_ += "Connection: close\r\n\r\n";
+
+	vector<boost::asio::const_buffer> gather = {
+			boost::asio::buffer(*header_), boost::asio::buffer(*body_)};
+	boost::asio::async_write(socket_, gather,
+			bind(&metrics_session::handle_write, self, _1, _2));
+}
+
+void metrics_session::handle_write(const error_code& ec, size_t len) {
+	error_code ignored;
+	socket_.shutdown(tcp::socket::shutdown_both, ignored);
+	socket_.close(ignored);
+	context_.dispatch->remove_ms(shared_from_this());
+}
+
+} // dew namespace
+
+#endif /* METRICS_SESSION_HPP_ */
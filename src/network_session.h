@@ -14,6 +14,7 @@ using ::boost::asio::io_service;
 using ::boost::asio::ip::tcp;
 using ::boost::chrono::steady_clock;
 using ::boost::chrono::milliseconds;
+using ::boost::asio::basic_waitable_timer;
 
 using ::std::stringstream;
 using ::std::string;
@@ -48,9 +49,17 @@ public:
 	void start_accept() { if(acceptor_.is_open()) do_accept(); }
 	void start_read() { if(socket_.is_open()) do_read(); }
 	void do_write(stringp);
+	void do_write(stringp, const write_stamp&);
 
 	void cancel_socket() { if(socket_.is_open()) socket_.cancel(); }
 
+	/* The command's response is binary, and gets no newline after it. */
+	void leave_unterminated() { unterminated_ = true; }
+
+	bool is_connected() { return socket_.is_open() && !acceptor_.is_open(); }
+	size_t queued() { return outbox_.size() + in_flight_.size(); }
+	string peer();
+
 /* December 15, 2015
  *
  * These variables are named by whether they are initialized by the constructor
@@ -60,15 +69,43 @@ private:
 	tcp::endpoint endpoint_;
 	tcp::acceptor acceptor_;
 	tcp::socket socket_;
+	basic_waitable_timer<steady_clock> linger_timer_;
 
 	const long BUFFER_LENGTH = 8192;
 	bBuff request = bBuff (BUFFER_LENGTH);
+	size_t filled_ = 0;
+	size_t read_at_ = 0;	/* where the read in progress puts its bytes */
+	sentence command;
+
+	/* Clients that don't end a request with a newline have it run once the
+	 * connection has been quiet for this long.
+	 */
+	const milliseconds LINGER = milliseconds(50);
+
+	/* October 18, 2026
+	 *
+	 * Writes queue in outbox while one gather write is in flight, so responses
+	 * go out in order and never interleave.  While a read's commands are being
+	 * run the session is corked and their responses leave in a single write.
+	 */
+	struct outgoing {
+		stringp message;
+		write_stamp stamp;
+	};
+	vector<outgoing> outbox_;
+	vector<outgoing> in_flight_;
+	vector<boost::asio::const_buffer> gather_;
+	bool corked_ = false;
+	bool unterminated_ = false;
 
 	void do_accept();
 	void do_read();
 	void handle_read(boost::system::error_code, size_t);
-	void handle_write(boost::system::error_code, size_t, bBuffp);
-	sentence buffer_to_sentence(int len);
+	void handle_write(boost::system::error_code, size_t);
+	void handle_linger(const boost::system::error_code&);
+	size_t execute_lines();
+	void execute_line(const char*, const char*, bool);
+	void flush();
 
 public:
 };
@@ -14,6 +14,7 @@
 #include <sstream>
 #include <vector>
 #include <cstdio>
+#include <cstring>
 
 #include <memory>
 #include <utility>
@@ -57,6 +58,7 @@ using ::std::size_t;
 
 using ::std::copy;
 using ::std::copy_n;
+using ::std::swap;
 
 using ::std::make_shared;
 using ::std::shared_ptr;
@@ -69,7 +71,8 @@ ns::network_session(context_struct context_in) :
 		context_(context_in),
 		endpoint_(),
 		acceptor_(*context_.service),
-		socket_(*context_.service)
+		socket_(*context_.service),
+		linger_timer_(*context_.service)
 {
 }
 
@@ -80,7 +83,8 @@ ns::network_session(
 		context_(context_in),
 		endpoint_(ep_in),
 		acceptor_(*context_.service, ep_in),
-		socket_(*context_.service)
+		socket_(*context_.service),
+		linger_timer_(*context_.service)
 {
 }
 
@@ -90,7 +94,8 @@ ns::network_session(
 ) :
 		context_(context_in),
 		acceptor_(*context_.service),
-		socket_(move(sock_in))
+		socket_(move(sock_in)),
+		linger_timer_(*context_.service)
 {
 }
 
@@ -98,16 +103,43 @@ nsp ns::get_ns() {
 	return shared_from_this();
 }
 
+string ns::peer() {
+	error_code ec;
+	auto ep = socket_.remote_endpoint(ec);
+	if(ec)
+		return string();
+	return ep.address().to_string() + ":" + to_string(ep.port());
+}
+
 void ns::do_write(stringp message) {
-	auto self (shared_from_this());
+	do_write(message, write_stamp{steady_clock::time_point(), nullptr, nullptr});
+}
+
+void ns::do_write(stringp message, const write_stamp& stamp) {
+	DEWD_TRACE_SCOPE(ns_do_write, 0, message->size());
 	if(socket_.is_open()) {
-		auto messagep = make_shared<bBuff>(message->begin(),message->end());
-		auto Message = boost::asio::buffer(*messagep);
-		boost::asio::async_write(
-					socket_, Message, bind(&ns::handle_write, self, _1, _2, messagep));
+		outbox_.push_back(outgoing{message, stamp});
+		if(!corked_)
+			flush();
 	}
 }
 
+/* Sends everything queued as one gather write straight out of the queued
+ * strings.  Anything queued meanwhile waits for handle_write.
+ */
+void ns::flush() {
+	if(!in_flight_.empty() || outbox_.empty())
+		return;
+
+	auto self (shared_from_this());
+	swap(in_flight_, outbox_);
+	gather_.clear();
+	for(auto& out : in_flight_)
+		gather_.emplace_back(boost::asio::buffer(*out.message));
+	boost::asio::async_write(
+				socket_, gather_, bind(&ns::handle_write, self, _1, _2));
+}
+
 void ns::do_accept() {
 	auto self (shared_from_this());
 	acceptor_.async_accept(socket_,
@@ -122,10 +154,18 @@ void ns::do_accept() {
 
 void ns::do_read() {
 	auto self (shared_from_this());
-	socket_.async_read_some(boost::asio::buffer(request),bind(
-			&ns::handle_read,self,_1,_2));
+	read_at_ = filled_;
+	socket_.async_read_some(
+			boost::asio::buffer(request.data()+filled_, BUFFER_LENGTH-filled_),
+			bind(&ns::handle_read,self,_1,_2));
 }
 
+/* October 18, 2026
+ *
+ * Reads append to request after any partial line left by the previous read.
+ * Every complete line is run as its own command and the unfinished tail is
+ * moved to the front of the buffer to wait for the rest of its line.
+ */
 void ns::handle_read(
 		boost::system::error_code ec, size_t in_length) {
 	if(ec){
@@ -134,35 +174,96 @@ void ns::handle_read(
 	} else {
 	auto self (shared_from_this());
 
-	/* Cut out edge cases */
-	if (in_length >= BUFFER_LENGTH) {
+	/* handle_linger may have run the tail while this read was out, and the
+	 * read landed where the tail used to end.
+	 */
+	if(read_at_ != filled_)
+		std::memmove(request.data()+filled_, request.data()+read_at_, in_length);
+	filled_ += in_length;
+
+	corked_ = true;
+	size_t used = execute_lines();
+	corked_ = false;
+
+	if(used == 0 && filled_ >= (size_t)BUFFER_LENGTH) {
+		/* Cut out edge cases */
 		string exceeds ("Request exceeds length.\r\n");
 		do_write(make_shared<string>(exceeds));
-	} else {
-		sentence command = buffer_to_sentence(in_length);
-		context_.dispatch->execute_network_command(command, self);
-	}
+		filled_ = 0;
+	} else if(used < filled_) {
+		std::memmove(request.data(), request.data()+used, filled_-used);
+		filled_ -= used;
+		linger_timer_.expires_from_now(LINGER);
+		linger_timer_.async_wait(bind(&ns::handle_linger,self,_1));
+	} else
+		filled_ = 0;
+
+	flush();
 	do_read();
 	}
 }
 
-void ns::handle_write(
-		boost::system::error_code ec, size_t in_length, bBuffp buffer) {
-	buffer.reset();
-	return;
+void ns::handle_linger(const boost::system::error_code& ec) {
+	/* A read that arrived after this wait was queued pushed the expiry forward
+	 * and owns the tail now.
+	 */
+	if(ec || filled_ == 0 || linger_timer_.expires_at() > steady_clock::now())
+		return;
+
+	const char* first = reinterpret_cast<const char*>(request.data());
+	execute_line(first, first+filled_, false);
+	filled_ = 0;
 }
 
+size_t ns::execute_lines() {
+	const char* first = reinterpret_cast<const char*>(request.data());
+	const char* last = first + filled_;
+	const char* line = first;
+	const char* eol;
 
-sentence ns::buffer_to_sentence(int len) {
-	stringstream ss;
-	for(auto c : make_iterator_range(request.begin(),request.begin()+len))
-	ss << c;
-	sentence s;
-	string in;
-	while(ss >> in)
-		s.push_back(in);
+	while((eol = static_cast<const char*>(std::memchr(line, '\n', last-line)))) {
+		execute_line(line, eol, true);
+		line = eol+1;
+	}
+	return line - first;
+}
+
+/* A newline terminated request gets a newline terminated response so that
+ * pipelined responses can be told apart.  Unterminated requests are answered
+ * exactly as before.
+ */
+void ns::execute_line(const char* first, const char* last, bool terminated) {
+	static const stringp newline = make_shared<string>("\n");
+
+	tokenize(first, last, command);
+	if(command.empty())
+		return;
 
-	return s;
+	size_t queued = outbox_.size();
+	unterminated_ = false;
+	context_.dispatch->execute_network_command(command, shared_from_this());
+
+	if(terminated && outbox_.size() > queued && !unterminated_) {
+		auto& response = *outbox_.back().message;
+		if(response.empty() || response.back() != '\n')
+			do_write(newline);
+	}
+}
+
+void ns::handle_write(
+		boost::system::error_code ec, size_t in_length) {
+	if(!ec) {
+		auto now = steady_clock::now();
+		for(auto& out : in_flight_)
+			if(out.stamp.channel) {
+				out.stamp.channel->record(out.stamp.read, now);
+				out.stamp.port->record(out.stamp.read, now);
+			}
+	}
+	in_flight_.clear();
+	if(!ec)
+		flush();
+	return;
 }
 
 
@@ -29,6 +29,13 @@ using ::std::pair;
 using ::std::deque;
 using ::std::size_t;
 
+/* October 18, 2026 :: Frame sink
+ *
+ * Receives each frame in place of the dispatcher.  Only the framer benchmark
+ * sets one.
+ */
+typedef ::std::function<void(stringp, const frame_stamp&)> frame_sink;
+
 /*=============================================================================
  * December 15, 2015 :: serial_session class
  *
@@ -65,6 +72,13 @@ public:
 	 */
 	void start_write();
 	void start_read();
+	void start_sampling(milliseconds);
+
+	/* Hands bytes to the framer as if a read had returned them.  Used by
+	 * handle_read and by the framer benchmark.
+	 */
+	void receive(const bBuff&, size_t);
+	void set_frame_sink(frame_sink sink_in) { sink_ = sink_in; }
 
 
 
@@ -96,17 +110,51 @@ private:
 	string name_;
 	milliseconds timeout_;
   basic_waitable_timer<steady_clock> timer_;
+  basic_waitable_timer<steady_clock> write_timer_;
+  basic_waitable_timer<steady_clock> sample_timer_;
   bool read_type_is_timeout_;
   write_test_struct wts_{0};
 
   bool write_type_is_test = false;
+	time_point<steady_clock> next_write_ = steady_clock::now();
+	vector<pair<double,string> > name_mix_;
+	u8 write_seq_ = 0;
+	xoshiro256ss rng_;
 	const size_t MAX_FRAME_LENGTH = 4096;
 	const size_t BUFFER_LENGTH = 16000;
 	serial_icounter_struct ioctl_counters {0};
-	message_counter_struct counts {0};
+
+	/* October 18, 2026 :: UART counter cache
+	 *
+	 * With a sample interval set, ioctl_counters is refreshed by sample_timer_
+	 * and queries are answered from it.  Rates are per second over the last
+	 * sample interval.  A zero interval keeps the ioctl per query.
+	 */
+	serial_icounter_struct prev_counters {0};
+	time_point<steady_clock> counters_taken = steady_clock::now();
+	time_point<steady_clock> next_sample_ = steady_clock::now();
+	milliseconds sample_interval_ = milliseconds(0);
+	rate_gauge rx_rate;
+	rate_gauge tx_rate;
+	rate_gauge overrun_rate;
+
+	/* The message counters are sampled on the same timer.  Averages have a
+	 * ten second time constant.
+	 */
+	const double RATE_TAU = 10.0;
+	message_rate_struct rates;
+	int64_t prev_received = 0;
+	int64_t prev_bytes = 0;
+	int64_t prev_lost = 0;
+
+	message_counter_struct counts;
 	time_point<steady_clock> front_last = steady_clock::now();
+	time_point<steady_clock> last_read = steady_clock::now();
+	port_latency_struct latency;
+	uint16_t port_id_ = context_.dispatch->register_port(name_);
 	time_point<steady_clock> dead = steady_clock::now();
 	pBuff to_parse;
+	frame_sink sink_;
 
 /* December 15, 2015 :: serial_session methods
  *
@@ -128,11 +176,23 @@ private:
 	void check_the_deque();
 	int scrub(pBuff::iterator);
 	int pop_counters();
+	void refresh_counters();
 	bBuffp generate_message();
+	void generate_frame(bBuff&);
+	void seed_rng();
+	void build_name_mix();
+	string pick_name();
+	double uniform();
+	int uniform_int(int, int);
+	bool chance(double);
 
 /* Method type: time handling */
 	void set_read_timer();
 	void handle_read_timeout(const error_code&);
+	void set_write_timer();
+	void handle_write_timeout(const error_code&);
+	void set_sample_timer();
+	void handle_sample_timeout(const error_code&);
 
 /* Method type: basic information */
 public:
@@ -153,8 +213,20 @@ public:
 	string get_msg_bytes_tot();
 	string get_wrapper_bytes_tot();
 	string get_garbage();
+	string get_rx_rate();
+	string get_tx_rate();
+	string get_overrun_rate();
+	string get_frame_rate();
+	string get_byte_rate();
+	string get_loss_rate();
 	string get_name();
 	string get_type();
+	void append_stats(string&);
+	port_latency_struct& get_latency() { return latency; }
+	const message_counter_struct& get_counts() { return counts; }
+	const serial_icounter_struct& get_icount() { refresh_counters(); return ioctl_counters; }
+	size_t get_buffered() { return to_parse.size(); }
+	size_t get_max_frame_length() const { return MAX_FRAME_LENGTH; }
 };
 
 } // dew namespace
@@ -64,9 +64,6 @@ using ::std::string;
 using ::std::vector;
 using ::std::deque;
 
-using ::std::srand;
-using ::std::rand;
-
 using ::std::search;
 using ::std::find;
 using ::std::copy;
@@ -92,6 +89,8 @@ serial_session::serial_session(
 		name_(device_in),
 		timeout_(timeout_in),
 		timer_(*context_.service),
+		write_timer_(*context_.service),
+		sample_timer_(*context_.service),
 		read_type_is_timeout_(true)
 {
 }
@@ -115,6 +114,8 @@ serial_session::serial_session(
 		name_(device_in),
 		timeout_(milliseconds(0)),
 		timer_(*context_.service),
+		write_timer_(*context_.service),
+		sample_timer_(*context_.service),
 		read_type_is_timeout_(false),
 		wts_(wts_in)
 {
@@ -126,7 +127,9 @@ shared_ptr<serial_session> ss::get_ss() {
 
 void ss::start_write() {
 	write_type_is_test = true;
-	srand(time(0));
+	seed_rng();
+	build_name_mix();
+	next_write_ = steady_clock::now();
 	do_write();
 }
 
@@ -136,6 +139,15 @@ void ss::start_read() {
 		set_read_timer();
 }
 
+void ss::start_sampling(milliseconds interval) {
+	sample_interval_ = interval;
+	if(sample_interval_ > milliseconds(0)) {
+		pop_counters();
+		next_sample_ = counters_taken;
+		set_sample_timer();
+	}
+}
+
 void ss::do_write() {
 	auto message = generate_message();
 	do_write(message);
@@ -153,6 +165,7 @@ void ss::do_read() {
 	auto buffer = make_shared<bBuff> (BUFFER_LENGTH);
 	auto Buffer = boost::asio::buffer(*buffer);
 	auto handler = bind(&ss::handle_read, self, _1, _2, buffer);
+	DEWD_TRACE(ss_do_read, port_id_, BUFFER_LENGTH);
 	if(read_type_is_timeout_)
 		boost::asio::async_read(port_, Buffer, handler);
 	else
@@ -160,23 +173,33 @@ void ss::do_read() {
 }
 
 void ss::handle_write(const error_code& ec, size_t len, bBuffp message) {
-	if(write_type_is_test)
-		do_write();
+	if(write_type_is_test) {
+		if(wts_.rate > 0)
+			set_write_timer();
+		else
+			do_write();
+	}
 	return;
 }
 
 void ss::handle_read(const error_code& ec, size_t len, bBuffp buffer) {
 	auto self (shared_from_this());
+	DEWD_TRACE_SCOPE(ss_handle_read, port_id_, len);
+	receive(*buffer, len);
+	do_read();
+}
+
+void ss::receive(const bBuff& buffer, size_t len) {
+	last_read = steady_clock::now();
 	counts.bytes_received += len;
 
-	if(!buffer->empty()) {
+	if(!buffer.empty()) {
 		if(to_parse.empty())
 			front_last = steady_clock::now();
-		copy(buffer->begin(),buffer->begin()+len, back_inserter(to_parse));
+		copy(buffer.begin(),buffer.begin()+len, back_inserter(to_parse));
 	}
 
 	set_a_check();
-	do_read();
 }
 
 void ss::scope(bBuffp buff) {
@@ -190,6 +213,7 @@ void ss::set_a_check() {
 
 void ss::check_the_deque() {
 	auto self (shared_from_this());
+	DEWD_TRACE_SCOPE(ss_check_the_deque, port_id_, to_parse.size());
 	/* The deque to check is d. From least restrictive to most restrictive, we
 	 * check that:
 	 * 1. size(d) > 0
@@ -217,15 +241,19 @@ void ss::check_the_deque() {
 	 * nonce1(4) + FE + FF = 6 characters.  If we have fewer than 18 characters
 	 * in to_parse then we cannot succeed.
 	 *
-	 * The payload is a google protobuf message of unknown length, so we stay
-	 * at the conservative 18 character minimum.
+	 * The payload is a google protobuf message or a raw waveform record, either
+	 * of unknown length, so we stay at the conservative 18 character minimum.
+	 * Telling the two apart is left to the dispatcher.
 	 */
 	if(to_parse.size() < 18)
 		return;
 	assert(to_parse.size()>=18);
 
+	/* The second byte may itself be the FF of the next frame, as when a frame
+	 * follows the FE FF that closed the one before it.
+	 */
 	if(to_parse[0]!=0xff || to_parse[1]!=0xfe) {
-		counts.bad_prefix += scrub(to_parse.begin()+2);
+		counts.bad_prefix += scrub(to_parse.begin()+1);
 		set_a_check();
 		return;
 	}
@@ -304,19 +332,25 @@ void ss::check_the_deque() {
 
 		counts.wrapper_bytes_tot += xfix.size();
 		counts.msg_bytes_tot += to_send->size();
-		counts.garbage += scrub(match_point+6);
-		counts.garbage -= to_send->size();
+
+		/* scrub eats the whole frame along with whatever follows it. */
+		counts.garbage += scrub(match_point+6) - to_send->size() - xfix.size();
 
 		assert(xfix.size()>=11);
 		counts.curr_msg = (int)(xfix.at(10));
 		if(counts.last_msg > counts.curr_msg )
 			counts.last_msg -= 256;
-		while(counts.last_msg < counts.curr_msg - 1){
-			++counts.last_msg;
-			++counts.messages_lost_tot;
-		}
-		counts.last_msg=counts.curr_msg;
-		context_.dispatch->delivery(to_send);
+		if(counts.last_msg < counts.curr_msg - 1)
+			counts.messages_lost_tot += counts.curr_msg - 1 - counts.last_msg;
+		counts.last_msg = (int64_t)counts.curr_msg;
+
+		/* The frame is stamped with the read that completed it. */
+		latency.extract.record(last_read, steady_clock::now());
+		frame_stamp stamp {last_read, &latency, port_id_};
+		if(sink_)
+			sink_(to_send, stamp);
+		else
+			context_.dispatch->delivery(to_send, stamp);
 
 		/* Loop checks until to_parse has no more messages waiting for us. */
 		set_a_check();
@@ -333,91 +367,203 @@ int ss::scrub(pBuff::iterator iter) {
 
 int ss::pop_counters() {
 	memset(&ioctl_counters, 0, sizeof(serial_icounter_struct));
+	counters_taken = steady_clock::now();
 	return ioctl(fd_, TIOCGICOUNT, &ioctl_counters);
 }
 
+/* Queries only pay for the ioctl when no sampler is keeping the cache. */
+void ss::refresh_counters() {
+	if(sample_interval_ == milliseconds(0))
+		pop_counters();
+}
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Unpaced test ports keep the original behaviour of writing ~1024 byte chunks
+ * as fast as the port accepts them.  Paced ports write exactly one burst of
+ * frames per tick of the write timer.
+ */
 bBuffp ss::generate_message() {
 	auto message = make_shared<bBuff>();
 
-	while(message->size() < 1024) {
-		++counts.messages_sent;
-		bBuff nonce1 = {0xff, 0xfe}, nonce2;
-		u8 byte;
+	if(wts_.rate > 0) {
+		for(int i = (wts_.burst > 0 ? wts_.burst : 1) ; i ; --i)
+			generate_frame(*message);
+	} else {
+		while(message->size() < 1024)
+			generate_frame(*message);
+	}
 
-		for(int i=4;i;--i) {
-			byte = (u8)(mod(rand(),256));
-			nonce1.emplace_back(byte);
-			byte = (u8)(mod(rand(),256));
-			nonce2.emplace_back(byte);
-		}
-		/* nonce 1 add */
-		copy(nonce1.begin(), nonce1.end(), back_inserter(*message));
+	return message;
+}
 
-		/* nonce2 add */
-		copy(nonce2.begin(), nonce2.end(), back_inserter(*message));
+void ss::generate_frame(bBuff& message) {
+	++counts.messages_sent;
+	++write_seq_;
 
-		/* msg number sequence */
-		message->push_back(mod(counts.messages_sent,256));
+	/* Skipping a sequence number looks like a lost frame to the reader. */
+	if(chance(wts_.p_lost))
+		++write_seq_;
 
-		assert(message->size()>=11);
-		u8 crc = crc8(make_iterator_range(message->end()-11,message->end()));
+	bBuff nonce1 = {0xff, 0xfe}, nonce2;
 
-		/* crc byte */
-		message->push_back(crc);
+	/* One draw supplies all eight nonce bytes. */
+	u64 bytes = rng_();
+	for(int i=4;i;--i) {
+		nonce1.emplace_back((u8)bytes);
+		bytes >>= 8;
+		nonce2.emplace_back((u8)bytes);
+		bytes >>= 8;
+	}
+	/* nonce 1 add */
+	copy(nonce1.begin(), nonce1.end(), back_inserter(message));
 
-		int num = mod(rand(),10);
-		string name (to_string(num) + "of09");
+	/* nonce2 add */
+	copy(nonce2.begin(), nonce2.end(), back_inserter(message));
 
+	/* msg number sequence */
+	message.push_back(write_seq_);
 
-		flopointpb::FloPointMessage fpwf;
-		fpwf.set_name(name);
+	assert(message.size()>=11);
+	u8 crc = crc8(make_iterator_range(message.end()-11,message.end()));
 
+	/* crc byte, possibly spoiled to exercise bad_crc */
+	if(chance(wts_.p_bad_crc))
+		crc = ~crc;
+	message.push_back(crc);
 
-		/*=========================================================================
-		 * Waveform generated is simple sigmoid
-		 *  peak / ( 1 + e^ (c * (i-32)))
-		 * where c is a constant between .16 and .4 and i is evaluated on integers
-		 * 0 to 63.
-		 */
+	string name (pick_name());
 
-		/* Once allocated, this memory is freed when *fpwf is deleted */
-		auto wf = new flopointpb::FloPointMessage_Waveform;
+	flopointpb::FloPointMessage fpwf;
+	fpwf.set_name(name);
 
-		double to_add = 0.0;
-		if(wts_.sample_size > 0)
-			to_add = (wts_.max_c-wts_.min_c)*mod(counts.messages_sent,wts_.sample_size)/wts_.sample_size;
-		else
-			to_add = (wts_.max_c-wts_.min_c)*(rand()/RAND_MAX);
 
-		double c = wts_.min_c + to_add;
+	/*=========================================================================
+	 * Waveform generated is simple sigmoid
+	 *  peak / ( 1 + e^ (c * (i-n/2)))
+	 * where c is a constant between .16 and .4 and i is evaluated on integers
+	 * 0 to n-1.  n is 64 unless the load profile asks for something else.
+	 */
 
-		for(int i = 0  ; i<64 ; ++i) {
-			double value = wts_.peak / (1 + exp(c*(32-i)));
-			u32 int_value = static_cast<u32>(value);
-			wf->add_wheight(int_value);
-		}
+	/* Once allocated, this memory is freed when *fpwf is deleted */
+	auto wf = new flopointpb::FloPointMessage_Waveform;
 
-		fpwf.set_allocated_waveform(wf);
-
-		string fpwf_str;
-		if(!(fpwf.SerializeToString(&fpwf_str))) {
-			string filename;
-			filename += context_.dispatch->get_logdir();
-			filename +=	name_.substr(name_.find_last_of("/\\")+1);
-			filename +=".message_generation";
-			FILE * logfile = fopen(filename.c_str(),"a");
-			string s;
-			s += to_string(steady_clock::now());
-			s += ": Could not serialize message to string.\n";
-			std::fwrite(s.c_str(), sizeof(u8), s.length(), logfile);
-			fclose(logfile);
-		}
+	double to_add = 0.0;
+	if(wts_.sample_size > 0)
+		to_add = (wts_.max_c-wts_.min_c)*mod(counts.messages_sent,wts_.sample_size)/wts_.sample_size;
+	else
+		to_add = (wts_.max_c-wts_.min_c)*uniform();
+
+	double c = wts_.min_c + to_add;
 
-		copy(fpwf_str.begin(), fpwf_str.end(), back_inserter(*message));
-		reverse_copy(nonce1.begin(),nonce1.end(), back_inserter(*message));
+	int lo = wts_.min_samples > 0 ? wts_.min_samples : 64;
+	int hi = wts_.max_samples > lo ? wts_.max_samples : lo;
+	int n = uniform_int(lo, hi);
+
+	for(int i = 0  ; i<n ; ++i) {
+		double value = wts_.peak / (1 + exp(c*(n/2-i)));
+		u32 int_value = static_cast<u32>(value);
+		wf->add_wheight(int_value);
 	}
 
-	return message;
+	fpwf.set_allocated_waveform(wf);
+
+	string fpwf_str;
+	bool serialized;
+	if(wts_.raw_payload) {
+		vector<int32_t> samples (wf->wheight().begin(), wf->wheight().end());
+		serialized = append_raw_waveform(fpwf_str, name, samples.data(), samples.size());
+	} else
+		serialized = fpwf.SerializeToString(&fpwf_str);
+	if(!serialized) {
+		string filename;
+		filename += context_.dispatch->get_logdir();
+		filename +=	name_.substr(name_.find_last_of("/\\")+1);
+		filename +=".message_generation";
+		FILE * logfile = fopen(filename.c_str(),"a");
+		string s;
+		s += to_string(steady_clock::now());
+		s += ": Could not serialize message to string.\n";
+		std::fwrite(s.c_str(), sizeof(u8), s.length(), logfile);
+		fclose(logfile);
+	}
+
+	/* A truncated frame never gets its trailer, so the reader holds the prefix
+	 * until it is too old or too long.
+	 */
+	if(chance(wts_.p_truncated)) {
+		copy(fpwf_str.begin(), fpwf_str.begin()+fpwf_str.size()/2,
+				back_inserter(message));
+	} else {
+		copy(fpwf_str.begin(), fpwf_str.end(), back_inserter(message));
+		reverse_copy(nonce1.begin(),nonce1.end(), back_inserter(message));
+	}
+
+	/* Garbage between frames never contains FF, so the reader eats all of it
+	 * in the scrub following the frame.
+	 */
+	if(chance(wts_.p_garbage))
+		for(int i = uniform_int(1,32) ; i ; --i)
+			message.push_back((u8)uniform_int(0,254));
+
+	/* An FF not followed by FE is a prefix that fails its first check. */
+	if(chance(wts_.p_bad_prefix)) {
+		message.push_back(0xff);
+		for(int i = uniform_int(1,16) ; i ; --i)
+			message.push_back((u8)uniform_int(0,253));
+	}
+}
+
+/* A fixed base seed is mixed with the device name so that every port draws
+ * its own reproducible stream.
+ */
+void ss::seed_rng() {
+	u64 seed = wts_.seed;
+	if(seed == 0)
+		seed = steady_clock::now().time_since_epoch().count();
+	rng_.reseed(seed ^ std::hash<string>()(name_));
+}
+
+void ss::build_name_mix() {
+	name_mix_.clear();
+	double total = 0.0;
+
+	if(wts_.names.empty())
+		for(int i = 0 ; i < 10 ; ++i)
+			name_mix_.emplace_back(total += 1.0, to_string(i) + "of09");
+
+	/* dewd checks the names at start up, so at least one has weight. */
+	for(auto& entry : wts_.names) {
+		string name;
+		double weight;
+		if(parse_name_weight(entry, name, weight) && weight > 0)
+			name_mix_.emplace_back(total += weight, name);
+	}
+}
+
+string ss::pick_name() {
+	if(name_mix_.empty())
+		build_name_mix();
+	double r = uniform() * name_mix_.back().first;
+	for(auto& entry : name_mix_)
+		if(r < entry.first)
+			return entry.second;
+	return name_mix_.back().second;
+}
+
+/* Uniform on [0,1). */
+double ss::uniform() {
+	return rng_.uniform();
+}
+
+/* Uniform on the closed interval [lo,hi]. */
+int ss::uniform_int(int lo, int hi) {
+	return lo + static_cast<int>(uniform() * (hi - lo + 1));
+}
+
+bool ss::chance(double p) {
+	return p > 0 && uniform() < p;
 }
 
 void ss::set_read_timer() {
@@ -436,14 +582,88 @@ void ss::handle_read_timeout(const error_code& ec) {
 	set_read_timer();
 }
 
-string ss::get_tx() {
+/* October 18, 2026
+ *
+ * Deadlines advance by a fixed period so the average rate doesn't drift with
+ * write latency.  A port that falls behind resumes from now rather than
+ * flooding to catch up.
+ */
+void ss::set_write_timer() {
+	auto self (shared_from_this());
+	int burst = wts_.burst > 0 ? wts_.burst : 1;
+	next_write_ += boost::chrono::nanoseconds(
+			static_cast<long long>(1e9 * burst / wts_.rate));
+
+	time_point<steady_clock> now = steady_clock::now();
+	if(next_write_ < now)
+		next_write_ = now;
+
+	write_timer_.expires_at(next_write_);
+	write_timer_.async_wait(bind(&ss::handle_write_timeout, self, _1));
+}
+
+void ss::handle_write_timeout(const error_code& ec) {
+	if(!ec)
+		do_write();
+}
+
+void ss::set_sample_timer() {
+	auto self (shared_from_this());
+	next_sample_ += sample_interval_;
+
+	/* After a stall, one sample over the whole gap rather than one per
+	 * interval missed.
+	 */
+	time_point<steady_clock> now = steady_clock::now();
+	if(next_sample_ < now)
+		next_sample_ = now;
+
+	sample_timer_.expires_at(next_sample_);
+	sample_timer_.async_wait(bind(&ss::handle_sample_timeout, self, _1));
+}
+
+/* The kernel counters are 32 bits wide and wrap, so deltas are taken in
+ * unsigned arithmetic.
+ */
+void ss::handle_sample_timeout(const error_code& ec) {
+	if(ec)
+		return;
+
+	prev_counters = ioctl_counters;
+	auto prev_taken = counters_taken;
 	pop_counters();
+
+	double seconds = boost::chrono::duration<double>(counters_taken - prev_taken).count();
+	if(seconds > 0) {
+		rx_rate.update((u32)(ioctl_counters.rx - prev_counters.rx) / seconds,
+				seconds, RATE_TAU);
+		tx_rate.update((u32)(ioctl_counters.tx - prev_counters.tx) / seconds,
+				seconds, RATE_TAU);
+		overrun_rate.update((u32)(ioctl_counters.overrun - prev_counters.overrun) / seconds,
+				seconds, RATE_TAU);
+
+		int64_t received = counts.messages_received;
+		int64_t bytes = counts.bytes_received;
+		int64_t lost = counts.messages_lost_tot;
+		rates.frames.update((received - prev_received) / seconds, seconds, RATE_TAU);
+		rates.bytes.update((bytes - prev_bytes) / seconds, seconds, RATE_TAU);
+		rates.lost.update((lost - prev_lost) / seconds, seconds, RATE_TAU);
+		prev_received = received;
+		prev_bytes = bytes;
+		prev_lost = lost;
+	}
+
+	set_sample_timer();
+}
+
+string ss::get_tx() {
+	refresh_counters();
 	long int tx = (unsigned)ioctl_counters.tx;
 	return to_string(tx);
 }
 
 string ss::get_rx() {
-	pop_counters();
+	refresh_counters();
 	long int rx = (unsigned)ioctl_counters.rx;
 	return to_string(rx);
 }
@@ -505,6 +725,30 @@ string ss::get_garbage() {
 	return to_string(counts.garbage);
 }
 
+string ss::get_rx_rate() {
+	return to_string(rx_rate.window());
+}
+
+string ss::get_tx_rate() {
+	return to_string(tx_rate.window());
+}
+
+string ss::get_overrun_rate() {
+	return to_string(overrun_rate.window());
+}
+
+string ss::get_frame_rate() {
+	return to_string(rates.frames.window());
+}
+
+string ss::get_byte_rate() {
+	return to_string(rates.bytes.window());
+}
+
+string ss::get_loss_rate() {
+	return to_string(rates.lost.window());
+}
+
 string ss::get_name() {
 	return name_;
 }
@@ -513,6 +757,76 @@ string ss::get_type() {
 	return string("serial");
 }
 
+/* October 18, 2026
+ *
+ * Appends every message counter and UART counter of this port to out as a
+ * single JSON object.
+ */
+void ss::append_stats(string& out) {
+	refresh_counters();
+
+	auto field = [&out](const char* key, int64_t value) {
+		out += '"';
+		out += key;
+		out += "\":";
+		out += to_string(value);
+		out += ',';
+	};
+
+	out += "{\"port\":\"";
+	out += name_;
+	out += "\",";
+	field("messages_received", counts.messages_received);
+	field("messages_sent", counts.messages_sent);
+	field("bytes_received", counts.bytes_received);
+	field("last_msg", counts.last_msg);
+	field("curr_msg", counts.curr_msg);
+	field("messages_lost_tot", counts.messages_lost_tot);
+	field("frame_too_long", counts.frame_too_long);
+	field("frame_too_old", counts.frame_too_old);
+	field("bad_prefix", counts.bad_prefix);
+	field("bad_crc", counts.bad_crc);
+	field("wrapper_bytes_tot", counts.wrapper_bytes_tot);
+	field("msg_bytes_tot", counts.msg_bytes_tot);
+	field("garbage", counts.garbage);
+
+	out += "\"icount\":{";
+	field("cts", (unsigned)ioctl_counters.cts);
+	field("dsr", (unsigned)ioctl_counters.dsr);
+	field("rng", (unsigned)ioctl_counters.rng);
+	field("dcd", (unsigned)ioctl_counters.dcd);
+	field("rx", (unsigned)ioctl_counters.rx);
+	field("tx", (unsigned)ioctl_counters.tx);
+	field("frame", (unsigned)ioctl_counters.frame);
+	field("overrun", (unsigned)ioctl_counters.overrun);
+	field("parity", (unsigned)ioctl_counters.parity);
+	field("brk", (unsigned)ioctl_counters.brk);
+	field("buf_overrun", (unsigned)ioctl_counters.buf_overrun);
+	out.back() = '}';
+
+	if(sample_interval_ > milliseconds(0)) {
+		auto rate = [&out](const char* key, const rate_gauge& gauge) {
+			out += '"';
+			out += key;
+			out += "\":{\"window\":";
+			out += to_string(gauge.window());
+			out += ",\"ewma\":";
+			out += to_string(gauge.ewma());
+			out += "},";
+		};
+
+		out += ",\"rates\":{";
+		rate("frames", rates.frames);
+		rate("bytes", rates.bytes);
+		rate("lost", rates.lost);
+		rate("rx", rx_rate);
+		rate("tx", tx_rate);
+		rate("overrun", overrun_rate);
+		out.back() = '}';
+	}
+	out += '}';
+}
+
 
 } // dew namespace
 
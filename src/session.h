@@ -15,6 +15,7 @@ namespace dew {
 using ::boost::asio::io_service;
 using ::boost::asio::ip::tcp;
 using ::boost::asio::serial_port;
+using ::boost::asio::basic_waitable_timer;
 using ::boost::chrono::steady_clock;
 using ::boost::chrono::time_point;
 using ::boost::chrono::milliseconds;
@@ -51,15 +52,79 @@ private:
 	context_struct_lite context_;
 	string logdir_;
 	write_test_struct wts_;
+	milliseconds sample_interval_ = milliseconds(0);
+	basic_waitable_timer<steady_clock> metrics_timer_;
+	basic_waitable_timer<steady_clock> stats_timer_;
 
 	list<ssp> serial_reading;
 	list<ssp> serial_writing;
 	list<nsp> network;
+	list<msp> metrics;
+
+	/* The Prometheus page is rebuilt on metrics_timer_ and shared by every
+	 * scrape until the next rebuild.
+	 */
+	stringp metrics_page_ = make_shared<string>();
+	milliseconds metrics_interval_ = milliseconds(1000);
+
+	/* October 18, 2026 :: Subscription configs
+	 *
+	 * A channel's subscribers are grouped by the options they subscribed with.
+	 * Each group decides once per message whether it is due, and every member
+	 * of a due group is sent the same string.  That string is built at most
+	 * once per message per channel, however many groups and members there are.
+	 */
+	struct subscription {
+		unsigned every;
+		bool stamped;
+		bool delimited;
+		u64 seen;
+		set<nsp> subscribers;
+
+		bool due() { return seen++ % every == 0; }
+		bool same_options(const subscription& o) const {
+			return every == o.every && stamped == o.stamped && delimited == o.delimited;
+		}
+	};
+
+	/* seq counts the messages published on the channel. */
+	struct subscription_list : list<subscription> {
+		u64 seq = 0;
+	};
+
+	/* October 18, 2026 :: Stamped subscriptions
+	 *
+	 * A stamped subscriber gets a line ahead of every message:
+	 * 	#<channel seq>\t<history seq>\t<unix seconds>\t<bytes>\n
+	 * The channel seq counts every message the channel carried, so a jump that
+	 * every doesn't account for means messages were missed.  The history seq
+	 * is what subscribe ... from takes to have them sent again.  A field that
+	 * doesn't apply is "-": the history seq of a stats_1s window, or the
+	 * channel seq of a replayed message.  The line is built once per message
+	 * per channel and goes out as its own buffer ahead of the shared message.
+	 */
+	struct origin {
+		u64 history_seq;
+		int64_t time_us;
+	};
+	static const u64 NO_SEQ = ~0ULL;
+
+	/* Where a subscription's replay of the history starts, when it asks for
+	 * one.
+	 */
+	struct replay_point {
+		enum { none, by_seq, by_time } from = none;
+		u64 seq = 0;
+		int64_t time_us = 0;
+	};
 
-	map<string,set<nsp> > subscriptions = {
+	map<string,subscription_list> subscriptions = {
 			{"raw_waveforms",{}},
 			{"ascii_waveforms",{}},
 			{"protobuf_all",{}},
+			{"stats_1s",{}},
+			{"features",{}},
+			{"compressed_waveforms",{}},
 			{"0of09_enc",{}},
 			{"1of09_enc",{}},
 			{"2of09_enc",{}},
@@ -72,9 +137,48 @@ private:
 			{"9of09_enc",{}}
 	};
 
-	deque<stringp> pbs_locations;
+	/* forward's scratch: the scanned message and its decoded samples. */
+	flopoint_view view_;
+	vector<int32_t> samples_;
+
+	/* Every parsed message, with its features when they were computed
+	 * (samples is zero when they weren't).
+	 */
+	history_store history_;
+	bool features_enabled_ = false;
+
+	/* compressed_waveforms is one stream shared by every subscriber, so a
+	 * subscriber joining starts it over with a keyframe for each name.
+	 */
+	waveform_encoder compressor_;
+
+	/* The history's copy on disk, when it is kept. */
+	std::unique_ptr<history_file> history_file_;
+
+	/* Serial port names by port id, which history records and trace events
+	 * carry.  Ids start at 1 so that 0 can mean "no port".
+	 */
+	vector<string> port_names_ = {""};
+
+	/* stats_1s gathers min, max and sum per sample index over one window of
+	 * waveforms and publishes them when stats_timer_ closes the window.  The
+	 * timer only runs while the channel has subscribers.
+	 */
+	struct waveform_window {
+		vector<int32_t> min;
+		vector<int32_t> max;
+		vector<int64_t> sum;
+		vector<uint32_t> count;
+		u64 messages;
+	};
+	waveform_window window_ {};
+	const milliseconds STATS_WINDOW = milliseconds(1000);
+	time_point<steady_clock> next_stats_ = steady_clock::now();
+	bool stats_running_ = false;
+
+	/* Latency to write completion, per channel. */
+	map<string,latency_histogram> channel_latency;
 
-	const int max_size = 10000;
 	bool local_logging_enabled = false;
 
 
@@ -84,6 +188,9 @@ public:
 	nsp make_fp_ns (tcp::endpoint&);
 	nsp make_ns (tcp::socket&);
 	void remove_ns (nsp);
+	msp make_ms (tcp::endpoint&);
+	msp make_ms (tcp::socket&);
+	void remove_ms (msp);
 
 	ssp make_r_ss(string, unsigned short);
 	ssp make_rw_ss(string);
@@ -94,33 +201,63 @@ private:
 	ssp make_ss (string, unsigned short);
 	ssp make_sst (string);
 	ssp make_ss (string);
+	vector<ssp> serial_ports();
 
 /* Method type: network communications */
 public:
-	void execute_network_command(sentence, nsp);
-	nodep walk_tree( sentence, nodep);
-	void delivery(stringp);
+	void execute_network_command(const sentence&, nsp);
+	const node* walk_tree(const sentence&, const node*, size_t&);
+	void delivery(stringp, frame_stamp);
 	string get_command_tree_from_root();
+	stringp get_metrics_page() { return metrics_page_; }
 
 private:
 	stringp wrap(stringp);
-	void forward(stringp);
+	static void append_wrapped(string&, const string&);
+	void forward(stringp, frame_stamp);
+	template<typename Build>
+	void publish(const string&, Build, const frame_stamp*, const origin&);
+	static void append_stamp(string&, u64, u64, int64_t, size_t);
+	write_stamp stamp_for(const frame_stamp&, const string&);
 	void forward_handler(const error_code&,size_t, bBuffp, nsp);
 
-	stringp waveform_ts_ascii(shared_ptr<::flopointpb::FloPointMessage_Waveform>);
-	stringp waveform_ts_bytes(shared_ptr<::flopointpb::FloPointMessage_Waveform>);
+	static void append_ascii(string&, const int32_t*, size_t);
+	static void append_bytes(string&, const int32_t*, size_t);
 
-	void subscribe(nsp, string);
+	void subscribe(nsp, string, arguments);
 	void unsubscribe(nsp, string);
+	static bool parse_options(arguments, subscription&, replay_point&);
+	static bool parse_count(const string&, size_t, u64&);
+	static bool parse_unix_us(const string&, int64_t&);
+	void replay(nsp, const string&, const subscription&, const replay_point&);
+	stringp protobuf_of(const history_store::chunk&, size_t);
+	static void leave(subscription_list&, nsp);
+	static size_t subscriber_count(const subscription_list&);
+
+	void accumulate(const int32_t*, size_t);
+	stringp window_ascii();
+	void start_stats();
+	void set_stats_timer();
+	void handle_stats_timeout(const error_code&);
 
 	void ports_for_zabbix(nsp);
+	void get_stats(nsp);
+	void get_latency(nsp);
+	void get_trace(nsp);
 	void stored_pbs(nsp);
 	void stored_ascii_waveforms(nsp);
+	void stored_features(nsp);
 
-	int store_pbs(stringp);
+	void get_history(nsp, arguments);
+	void append_history(string&, const history_store::chunk&, size_t);
+	static int64_t unix_us(time_point<steady_clock>);
 
 	string command_tree_from(nodep);
 
+	void set_metrics_timer();
+	void handle_metrics_timeout(const error_code&);
+	void render_metrics();
+
 /* Method type: command tree building */
 public:
 	void build_command_tree();
@@ -129,9 +266,19 @@ private:
 	void make_branches();
 	void make_leaves();
 
+	static void reply(nsp, ssp, ss_getter);
+
+	static const vector<pair<string,ss_getter> >& counter_getters();
+	static const vector<pair<string,ss_getter> >& writer_counter_getters();
+
 /* Method type: basic information */
 public:
 	string get_logdir() { return logdir_; }
+	void set_sample_interval(milliseconds interval) { sample_interval_ = interval; }
+	void set_features(bool enabled) { features_enabled_ = enabled; }
+	void set_history(size_t messages, int64_t age_us) { history_.set_limits(messages, age_us); }
+	void persist_history(uint32_t slot_count, uint32_t slot_size);
+	uint16_t register_port(const string&);
 	void see_tree() {dprint(root->descendants(0));}
 
 /* Member type: command tree from root */
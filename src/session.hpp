@@ -18,6 +18,7 @@
 #include <set>
 #include <cstdio>
 #include <algorithm>
+#include <limits>
 #include <functional>
 
 #include <utility>
@@ -41,6 +42,7 @@
 #include "utils.h"
 #include "serial_session.h"
 #include "network_session.h"
+#include "metrics_session.h"
 #include "command_graph.h"
 
 #include "session.h"
@@ -103,7 +105,9 @@ dispatcher::dispatcher(
 ) :
 		context_(io_in),
 		logdir_(log_in),
-		wts_(wts_in)
+		wts_(wts_in),
+		metrics_timer_(*io_in),
+		stats_timer_(*io_in)
 {
 }
 
@@ -136,12 +140,37 @@ nsp dispatcher::make_ns (tcp::socket& sock_in) {
 void dispatcher::remove_ns (nsp to_remove) {
 	to_remove->cancel_socket();
 
-	//for(auto channel : channel_subscribers)
-	//	unsub(channel.first, to_remove);
+	for(auto& channel : subscriptions)
+		leave(channel.second, to_remove);
 
 	network.remove(to_remove);
 }
 
+/* The listening metrics session also starts the page renderer, so nothing is
+ * rendered unless someone can scrape it.
+ */
+msp dispatcher::make_ms (tcp::endpoint& ep_in) {
+	auto pt = make_shared<metrics_session>(context_struct(context_, shared_from_this()),ep_in);
+	pt->start_accept();
+	metrics.emplace_back(pt->get_ms());
+	if(sample_interval_ > milliseconds(0))
+		metrics_interval_ = sample_interval_;
+	render_metrics();
+	set_metrics_timer();
+	return pt->get_ms();
+}
+
+msp dispatcher::make_ms (tcp::socket& sock_in) {
+	auto pt = make_shared<metrics_session>(context_struct(context_, shared_from_this()), sock_in);
+	pt->start_read();
+	metrics.emplace_back(pt->get_ms());
+	return pt->get_ms();
+}
+
+void dispatcher::remove_ms (msp to_remove) {
+	metrics.remove(to_remove);
+}
+
 ssp dispatcher::make_r_ss(string device_name, unsigned short timeout) {
 	auto pt = make_ss(device_name, timeout);
 	serial_reading.emplace_back(pt->get_ss());
@@ -182,45 +211,67 @@ ssp dispatcher::make_w_ss(string device_name) {
 ssp dispatcher::make_ss(string device_name, unsigned short timeout) {
 	auto pt = make_shared<ss>(context_struct(context_, shared_from_this()), device_name,
 			milliseconds(timeout));
+	pt->start_sampling(sample_interval_);
 	return pt->get_ss();
 }
 
 ssp dispatcher::make_sst(string device_name) {
 	auto pt = make_shared<ss>(context_struct(context_, shared_from_this()), device_name,
 			wts_);
+	pt->start_sampling(sample_interval_);
 	return pt->get_ss();
 }
 
 ssp dispatcher::make_ss(string device_name) {
 	auto pt = make_shared<ss>(context_struct(context_, shared_from_this()), device_name);
+	pt->start_sampling(sample_interval_);
 	return pt->get_ss();
 }
 
+/* Every serial port once, reading ports first. */
+vector<ssp> dispatcher::serial_ports() {
+	vector<ssp> ports (serial_reading.begin(), serial_reading.end());
+	for(auto port : serial_writing)
+		if(find(ports.begin(), ports.end(), port) == ports.end())
+			ports.emplace_back(port);
+	return ports;
+}
+
 /* December 15, 2015 :: network communications */
 
-void dispatcher::execute_network_command( sentence command, nsp reference) {
-	auto to_exec = walk_tree(command, root);
-	(*to_exec)(reference);
-}
-
-nodep dispatcher::walk_tree( sentence command, nodep current) {
-	if( command.empty() || current->is_leaf())
-		return current;
-	else {
-		auto iter = current->get_child(command[0]);
-		if(iter == current->get_end())
-			return current;
-		else {
-			command.pop_front();
-			current = iter->second;
-			return walk_tree(command, current);
-		}
+void dispatcher::execute_network_command(const sentence& command, nsp reference) {
+	size_t used = 0;
+	auto to_exec = walk_tree(command, root.get(), used);
+	(*to_exec)(reference, arguments(command.begin()+used, command.end()));
+}
+
+/* Descends one level per word until a word has no matching child or we reach
+ * a leaf.  The tree owns every node for the life of the dispatcher, so plain
+ * pointers are safe here and spare us the reference counting.  used counts the
+ * words matched.
+ */
+const node* dispatcher::walk_tree(const sentence& command, const node* current,
+		size_t& used) {
+	used = 0;
+	for(auto& w : command) {
+		if(current->is_leaf())
+			break;
+		auto child = current->get_child(w);
+		if(!child)
+			break;
+		current = child;
+		++used;
 	}
+	return current;
 }
 
-void dispatcher::delivery(shared_ptr<string> message) {
+void dispatcher::delivery(shared_ptr<string> message, frame_stamp stamp) {
 	auto self (shared_from_this());
-	context_.service->post(bind(&dispatcher::forward,self,message));
+	context_.service->post(bind(&dispatcher::forward,self,message,stamp));
+}
+
+write_stamp dispatcher::stamp_for(const frame_stamp& stamp, const string& channel) {
+	return write_stamp{stamp.read, &channel_latency[channel], &stamp.port->write};
 }
 
 stringp dispatcher::wrap(stringp str_in) {
@@ -228,47 +279,160 @@ stringp dispatcher::wrap(stringp str_in) {
 	 * 	ff fe <msg> <crc8 of msg> fe ff
 	 *
 	 * This allows waltr some way of delimiting full messages.
+	 *
+	 * October 18, 2026: built straight into one string, once per message, and
+	 * shared by every subscriber of the channel.
 	 */
 
-	pBuff base (str_in->size());
-	bBuff delim = {0xfe, 0xff};
-	copy(str_in->begin(), str_in->end(), base.begin());
-	base.push_back(crc8(make_iterator_range(str_in->begin(),str_in->end())));
-	copy(delim.begin(), delim.end(), front_inserter(base));
-	copy(delim.begin(), delim.end(), back_inserter(base));
-
-	auto str_return = make_shared<string>(base.begin(),base.end());
+	auto str_return = make_shared<string>();
+	str_return->reserve(str_in->size() + 5);
+	append_wrapped(*str_return, *str_in);
 	return str_return;
 }
 
-void dispatcher::forward(shared_ptr<string> message) {
-
-	auto fpm = make_shared<flopointpb::FloPointMessage>();
-	bool parse_successful = fpm->ParseFromString(*message);
+void dispatcher::append_wrapped(string& out, const string& message) {
+	out.append("\xff\xfe", 2);
+	out.append(message);
+	out.push_back(crc8(make_iterator_range(message.begin(),message.end())));
+	out.append("\xfe\xff", 2);
+}
 
-	if(parse_successful) {
-		store_pbs(message);
-		auto fpwf = make_shared<::flopointpb::FloPointMessage_Waveform>(fpm->waveform());
+/* Sends to every due group of the channel.  build is called at most once, and
+ * only if some group is due.  Writes without a frame stamp go unmeasured.
+ */
+template<typename Build>
+void dispatcher::publish(const string& channel, Build build, const frame_stamp* stamp,
+		const origin& from) {
+	auto configs = subscriptions.find(channel);
+	if(configs == subscriptions.end())
+		return;
+
+	u64 seq = configs->second.seq++;
+	stringp out;
+	stringp head;
+	stringp length;
+	write_stamp out_stamp {steady_clock::time_point(), nullptr, nullptr};
+	for(auto& config : configs->second) {
+		if(!config.due())
+			continue;
+		if(!out) {
+			out = build();
+			if(stamp)
+				out_stamp = stamp_for(*stamp, channel);
+		}
+		if(config.stamped && !head) {
+			head = make_shared<string>();
+			append_stamp(*head, seq, from.history_seq, from.time_us, out->size());
+		}
+		if(config.delimited && !length) {
+			length = make_shared<string>();
+			append_varint(*length, out->size());
+		}
+		for(auto& subscriber : config.subscribers) {
+			if(config.stamped)
+				subscriber->do_write(head);
+			if(config.delimited)
+				subscriber->do_write(length);
+			subscriber->do_write(out, out_stamp);
+		}
+	}
+}
 
-		for(auto subscriber : subscriptions["raw_waveforms"])
-				subscriber->do_write(waveform_ts_bytes(fpwf));
+void dispatcher::append_stamp(string& out, u64 channel_seq, u64 history_seq,
+		int64_t time_us, size_t length) {
+	out.push_back('#');
+	out += channel_seq == NO_SEQ ? "-" : to_string(channel_seq);
+	out.push_back('\t');
+	out += history_seq == NO_SEQ ? "-" : to_string(history_seq);
+	char rest[64];
+	snprintf(rest, sizeof(rest), "\t%lld.%06lld\t%zu\n",
+			(long long)(time_us / 1000000), (long long)(time_us % 1000000), length);
+	out += rest;
+}
 
-		for(auto subscriber : subscriptions["ascii_waveforms"])
-				subscriber->do_write(waveform_ts_ascii(fpwf));
+/* October 18, 2026
+ *
+ * The message is scanned rather than parsed: only the name and the samples
+ * are pulled out, and every channel, the history and the message log work
+ * from those.
+ */
+void dispatcher::forward(shared_ptr<string> message, frame_stamp stamp) {
+	DEWD_TRACE_SCOPE(dispatcher_forward, stamp.port_id, message->size());
 
-		for(auto subscriber : subscriptions["protobuf_all"])
-				subscriber->do_write(message);
+	/* A raw record already holds the samples as they are stored. */
+	bool raw = is_raw_waveform(*message);
+	bool parse_successful = raw ? read_raw_waveform(*message, view_, samples_)
+			: scan_flopoint(*message, view_) && decode_int32_runs(view_.wheight, samples_);
 
-		for(auto subscriber : subscriptions[fpm->name()+"_enc"])
-				subscriber->do_write(wrap(message));
+	if(parse_successful) {
+		stamp.port->parse.record(stamp.read, steady_clock::now());
+
+		const string name = view_.name_string();
+		const int32_t* samples = samples_.data();
+		size_t n = samples_.size();
+
+		/* Analysed when asked for on the command line or by a subscriber. */
+		bool analyse = features_enabled_ || !subscriptions["features"].empty();
+		waveform_features features {};
+		if(analyse)
+			features = compute_features(samples, n);
+
+		/* Raw records are stored without a protobuf, which is only built if a
+		 * protobuf_all or _enc subscriber asks for one.
+		 */
+		stringp pb = raw ? nullptr : message;
+		auto protobuf = [&]{
+			if(!pb) {
+				pb = make_shared<string>();
+				append_flopoint(*pb, name, samples, n);
+			}
+			return pb;
+		};
+
+		origin from {0, unix_us(stamp.read)};
+		from.history_seq = history_.append(from.time_us, stamp.port_id, name,
+				samples, n, pb, features);
+		if(history_file_)
+			history_file_->append(from.history_seq, from.time_us,
+					port_names_[stamp.port_id], name, samples, n, pb ? *pb : string(),
+					features);
+
+		if(analyse)
+			publish("features", [&]{
+				auto line = make_shared<string>();
+				append_features(*line, name, features);
+				return line;
+			}, &stamp, from);
+		publish("raw_waveforms", [&]{
+			auto line = make_shared<string>();
+			append_bytes(*line, samples, n);
+			return line;
+		}, &stamp, from);
+		publish("ascii_waveforms", [&]{
+			auto line = make_shared<string>();
+			append_ascii(*line, samples, n);
+			return line;
+		}, &stamp, from);
+		publish("compressed_waveforms", [&]{
+			auto record = make_shared<string>();
+			compressor_.encode(*record, name, samples, n);
+			return record;
+		}, &stamp, from);
+		publish("protobuf_all", protobuf, &stamp, from);
+		publish(name+"_enc", [&]{ return wrap(protobuf()); }, &stamp, from);
+
+		if(stats_running_)
+			accumulate(samples, n);
+
+		stamp.port->fanout.record(stamp.read, steady_clock::now());
 
 		if(local_logging_enabled){
 			FILE * log = fopen((logdir_ + "dispatch.message.log").c_str(),"a");
 			string s (to_string(steady_clock::now()) + ": Message received:\n");
-			s += "\tName: " + fpm->name() + '\n';
+			s += "\tName: " + name + '\n';
 			s += "\tWaveform: ";
-			for(int i = 0; i < fpm->waveform().wheight().size(); ++i)
-				s += to_string(fpm->waveform().wheight(i)) + '\n';
+			for(size_t i = 0; i < n; ++i)
+				s += to_string(samples[i]) + '\n';
 			std::fwrite(s.c_str(), sizeof(u8), s.length(), log);
 			fclose(log);
 		}
@@ -285,47 +449,87 @@ void dispatcher::forward(shared_ptr<string> message) {
 	}
 }
 
-stringp dispatcher::waveform_ts_ascii(
-		shared_ptr<::flopointpb::FloPointMessage_Waveform> fpm_p) {
-	auto ascii_wf_str = make_shared<string>();
-	for(auto wheight : fpm_p->wheight()) {
-		ascii_wf_str->append("\t");
-		ascii_wf_str->append(to_string(wheight));
+/* October 18, 2026 :: the ascii_waveforms and raw_waveforms lines, shared
+ * with the history replay.
+ */
+void dispatcher::append_ascii(string& out, const int32_t* samples, size_t n) {
+	for(size_t i = 0 ; i < n ; ++i) {
+		out.push_back('\t');
+		out.append(to_string(samples[i]));
 	}
-	ascii_wf_str->append("\n");
-	return ascii_wf_str;
+	out.push_back('\n');
 }
 
-
-stringp dispatcher::waveform_ts_bytes(
-		shared_ptr<::flopointpb::FloPointMessage_Waveform> fpm_p) {
-	auto raw_wf_str = make_shared<string>();
-	for(auto wheight : fpm_p->wheight()) {
-		raw_wf_str->append("\t");
-		raw_wf_str->append(to_string((wheight >> 24 ) & 0xFF));
-		raw_wf_str->append(to_string((wheight >> 16 ) & 0xFF));
-		raw_wf_str->append(to_string((wheight >> 8 ) & 0xFF));
-		raw_wf_str->append(to_string(wheight & 0xFF));
+void dispatcher::append_bytes(string& out, const int32_t* samples, size_t n) {
+	for(size_t i = 0 ; i < n ; ++i) {
+		int32_t wheight = samples[i];
+		out.push_back('\t');
+		out.append(to_string((wheight >> 24 ) & 0xFF));
+		out.append(to_string((wheight >> 16 ) & 0xFF));
+		out.append(to_string((wheight >> 8 ) & 0xFF));
+		out.append(to_string(wheight & 0xFF));
 	}
-	raw_wf_str->append("\n");
-
-	return raw_wf_str;
+	out.push_back('\n');
 }
 
-void dispatcher::subscribe(nsp sub, string channel) {
-	auto sub_set = subscriptions.find(channel);
-	if(sub_set->second.find(sub) == sub_set->second.end()) {
-		sub_set->second.emplace(sub);
-	} else
-		if(0)
-			sub->do_write(make_shared<string>("You are already subscribed to "+channel+"\n"));
+/* October 18, 2026
+ *
+ * subscribe to <channel> [every <n>] [stamped] [delimited]
+ * 		[from <seq> | since <unix seconds>]
+ *
+ * every n passes on one message in n, starting with the next one.  stamped
+ * puts a stamp line ahead of every message.  delimited, on protobuf_all only,
+ * puts the varint length ahead of every message as writeDelimitedTo does, so
+ * parseDelimitedFrom reads the stream as it comes.  Subscribing again to the
+ * same channel replaces the earlier options.
+ *
+ * from and since first replay the stored messages from that history seq or
+ * time on, in the channel's format, then carry on with live messages.  Both
+ * happen on the io thread, so the replay ends with the last message stored
+ * and the first live message is the one after it.  stats_1s has no replay.
+ *
+ * Each compressed_waveforms record may refer to the one before it with the
+ * same name, so that channel takes no every, and its replay is encoded
+ * afresh for the one subscriber.
+ */
+void dispatcher::subscribe(nsp sub, string channel, arguments options) {
+	subscription wanted {1, false, false, 0, {}};
+	replay_point from;
+	if(!parse_options(options, wanted, from)
+			|| (channel == "stats_1s" && from.from != replay_point::none)
+			|| (channel != "protobuf_all" && wanted.delimited)
+			|| (channel == "compressed_waveforms" && wanted.every != 1)) {
+		sub->do_write(make_shared<string>("Usage: subscribe to "+channel
+				+ (channel == "compressed_waveforms" ? "" : " [every <n>]") + " [stamped]"
+				+ (channel == "protobuf_all" ? " [delimited]" : "")
+				+ (channel == "stats_1s" ? "" : " [from <seq> | since <unix seconds>]")
+				+ "\n"));
+		return;
+	}
+	if(from.from != replay_point::none)
+		replay(sub, channel, wanted, from);
+
+	auto& configs = subscriptions.find(channel)->second;
+	leave(configs, sub);
+
+	auto config = configs.begin();
+	while(config != configs.end() && !config->same_options(wanted))
+		++config;
+	if(config == configs.end())
+		config = configs.insert(configs.end(), wanted);
+	config->subscribers.emplace(sub);
+
+	if(channel == "stats_1s")
+		start_stats();
+	if(channel == "compressed_waveforms")
+		compressor_.reset();
 }
 
 void dispatcher::unsubscribe(nsp sub, string channel) {
-	auto sub_set = subscriptions.find(channel);
-	auto locator = sub_set->second.find(sub);
-	if(locator != sub_set->second.end()) {
-		sub_set->second.erase(locator);
+	auto& configs = subscriptions.find(channel)->second;
+	size_t before = subscriber_count(configs);
+	leave(configs, sub);
+	if(subscriber_count(configs) < before) {
 		if(0)
 			sub->do_write(make_shared<string>("Unsubscribed from "+channel+"\n"));
 	} else
@@ -333,6 +537,230 @@ void dispatcher::unsubscribe(nsp sub, string channel) {
 			sub->do_write(make_shared<string>("You are not subscribed to "+channel+"\n"));
 }
 
+/* Options come in any order, each at most once.  every, from and since take
+ * a value.
+ */
+bool dispatcher::parse_options(arguments options, subscription& wanted,
+		replay_point& from) {
+	bool have_every = false;
+	for(size_t i = 0 ; i < options.size() ; ) {
+		string key (options[i].begin(), options[i].end());
+		++i;
+		if(key == "stamped" && !wanted.stamped) {
+			wanted.stamped = true;
+			continue;
+		}
+		if(key == "delimited" && !wanted.delimited) {
+			wanted.delimited = true;
+			continue;
+		}
+		if(i >= options.size())
+			return false;
+		string value (options[i].begin(), options[i].end());
+		++i;
+		u64 n = 0;
+		if(key == "every" && !have_every) {
+			if(!parse_count(value, 9, n) || n == 0)
+				return false;
+			wanted.every = n;
+			have_every = true;
+		} else if(key == "from" && from.from == replay_point::none) {
+			if(!parse_count(value, 19, n))
+				return false;
+			from.from = replay_point::by_seq;
+			from.seq = n;
+		} else if(key == "since" && from.from == replay_point::none) {
+			if(!parse_unix_us(value, from.time_us))
+				return false;
+			from.from = replay_point::by_time;
+		} else
+			return false;
+	}
+	return true;
+}
+
+/* A decimal count of at most digits digits. */
+bool dispatcher::parse_count(const string& text, size_t digits, u64& n) {
+	if(text.empty() || text.size() > digits)
+		return false;
+	n = 0;
+	for(char c : text) {
+		if(c < '0' || c > '9')
+			return false;
+		n = 10*n + (c - '0');
+	}
+	return true;
+}
+
+/* Unix seconds, fractions allowed, as microseconds. */
+bool dispatcher::parse_unix_us(const string& text, int64_t& us) {
+	char* end = nullptr;
+	double seconds = strtod(text.c_str(), &end);
+	if(text.empty() || *end != '\0')
+		return false;
+	us = static_cast<int64_t>(seconds * 1e6);
+	return true;
+}
+
+/* The stored messages for one subscriber, oldest first and thinned by every
+ * like the live ones.  Stored protobufs go out as they are, one buffer each;
+ * every other format is built into one string.  The session is corked while
+ * a command runs, so the lot leaves in a single gather write.
+ */
+void dispatcher::replay(nsp sub, const string& channel, const subscription& options,
+		const replay_point& from) {
+	bool pbs = channel == "protobuf_all";
+	bool enc = channel.size() > 4 && channel.compare(channel.size()-4, 4, "_enc") == 0;
+	uint32_t id = 0;
+	if(enc && !history_.find_name(channel.substr(0, channel.size()-4), id))
+		return;
+
+	auto text = make_shared<string>();
+	string body;
+	u64 seen = 0;
+	waveform_encoder compressor;
+
+	/* A newline after the replay would land in the middle of the stream. */
+	sub->leave_unterminated();
+	auto each = [&](const history_store::chunk& c, size_t i) {
+		if(enc && c.name[i] != id)
+			return;
+		if(channel == "features" && !c.features[i].samples)
+			return;
+		if(seen++ % options.every)
+			return;
+
+		if(pbs) {
+			stringp pb = protobuf_of(c, i);
+			if(options.stamped || options.delimited) {
+				auto head = make_shared<string>();
+				if(options.stamped)
+					append_stamp(*head, NO_SEQ, c.seq(i), c.time[i], pb->size());
+				if(options.delimited)
+					append_varint(*head, pb->size());
+				sub->do_write(head);
+			}
+			sub->do_write(pb);
+			return;
+		}
+
+		/* A stamp needs the length, so a stamped message is built apart. */
+		bool stamped = options.stamped;
+		string& out = stamped ? body : *text;
+		body.clear();
+		if(enc)
+			append_wrapped(out, *protobuf_of(c, i));
+		else if(channel == "features")
+			append_features(out, history_.name_of(c.name[i]), c.features[i]);
+		else if(channel == "ascii_waveforms")
+			append_ascii(out, c.samples_of(i), c.samples_in(i));
+		else if(channel == "raw_waveforms")
+			append_bytes(out, c.samples_of(i), c.samples_in(i));
+		else if(channel == "compressed_waveforms")
+			compressor.encode(out, history_.name_of(c.name[i]), c.samples_of(i), c.samples_in(i));
+		if(stamped) {
+			append_stamp(*text, NO_SEQ, c.seq(i), c.time[i], body.size());
+			text->append(body);
+		}
+	};
+
+	if(from.from == replay_point::by_seq)
+		history_.for_each_from(from.seq, each);
+	else
+		history_.for_each_since(from.time_us, each);
+
+	if(!text->empty())
+		sub->do_write(text);
+}
+
+/* Drops sub from every group of the channel, then any group left empty. */
+void dispatcher::leave(subscription_list& configs, nsp sub) {
+	if(sub)
+		for(auto& config : configs)
+			config.subscribers.erase(sub);
+	configs.remove_if([](const subscription& s) { return s.subscribers.empty(); });
+}
+
+size_t dispatcher::subscriber_count(const subscription_list& configs) {
+	size_t n = 0;
+	for(auto& config : configs)
+		n += config.subscribers.size();
+	return n;
+}
+
+/* October 18, 2026 :: stats_1s
+ *
+ * Waveforms need not share a length, so each sample index keeps its own count.
+ */
+void dispatcher::accumulate(const int32_t* samples, size_t n) {
+	if(window_.count.size() < n) {
+		window_.min.resize(n, std::numeric_limits<int32_t>::max());
+		window_.max.resize(n, std::numeric_limits<int32_t>::min());
+		window_.sum.resize(n, 0);
+		window_.count.resize(n, 0);
+	}
+	for(size_t i = 0 ; i < n ; ++i) {
+		int32_t v = samples[i];
+		if(v < window_.min[i])
+			window_.min[i] = v;
+		if(v > window_.max[i])
+			window_.max[i] = v;
+		window_.sum[i] += v;
+		++window_.count[i];
+	}
+	++window_.messages;
+}
+
+/* min, max and mean lines laid out like ascii_waveforms. */
+stringp dispatcher::window_ascii() {
+	auto out = make_shared<string>();
+	out->append("min");
+	for(auto v : window_.min)
+		out->append("\t" + to_string(v));
+	out->append("\nmax");
+	for(auto v : window_.max)
+		out->append("\t" + to_string(v));
+	out->append("\nmean");
+	char mean[32];
+	for(size_t i = 0 ; i < window_.sum.size() ; ++i) {
+		snprintf(mean, sizeof(mean), "\t%.1f", (double)window_.sum[i] / window_.count[i]);
+		out->append(mean);
+	}
+	out->append("\n");
+	return out;
+}
+
+void dispatcher::start_stats() {
+	if(stats_running_)
+		return;
+	stats_running_ = true;
+	window_ = waveform_window {};
+	next_stats_ = steady_clock::now();
+	set_stats_timer();
+}
+
+void dispatcher::set_stats_timer() {
+	auto self (shared_from_this());
+	next_stats_ += STATS_WINDOW;
+	stats_timer_.expires_at(next_stats_);
+	stats_timer_.async_wait(bind(&dispatcher::handle_stats_timeout, self, _1));
+}
+
+/* Windows without a message publish nothing. */
+void dispatcher::handle_stats_timeout(const error_code& ec) {
+	if(ec)
+		return;
+	if(window_.messages > 0)
+		publish("stats_1s", [this]{ return window_ascii(); }, nullptr,
+				origin{NO_SEQ, unix_us(steady_clock::now())});
+	window_ = waveform_window {};
+
+	if(subscriptions["stats_1s"].empty())
+		stats_running_ = false;
+	else
+		set_stats_timer();
+}
+
 void dispatcher::ports_for_zabbix(nsp in) {
 	string json ("{\"data\":[");
 	int not_first = 0;
@@ -348,36 +776,348 @@ void dispatcher::ports_for_zabbix(nsp in) {
 	in->do_write(make_shared<string>(json));
 }
 
-void dispatcher::stored_pbs(nsp in) {
-	::flopointpb::FloPointMultiMessage fpmm;
+/* October 18, 2026
+ *
+ * One JSON document holding every counter of every port, meant to be polled
+ * in place of one request per counter per port.
+ */
+void dispatcher::get_stats(nsp in) {
+	auto json = make_shared<string>("{\"ports\":[");
+	json->reserve(1024 * (serial_reading.size() + serial_writing.size()));
+
+	for(auto port : serial_ports()) {
+		port->append_stats(*json);
+		*json += ',';
+	}
+	if(json->back() == ',')
+		json->pop_back();
+	*json += "]}";
+
+	in->do_write(json);
+}
 
-	for(auto pbs : pbs_locations) {
-		auto fpm = fpmm.add_messages();
-		fpm->ParseFromString(*pbs);
+/* October 18, 2026
+ *
+ * Latency quantiles in nanoseconds, measured from the read completion that
+ * finished each frame.
+ */
+void dispatcher::get_latency(nsp in) {
+	auto json = make_shared<string>("{\"ports\":[");
+
+	for(auto port : serial_reading) {
+		auto& latency = port->get_latency();
+		*json += "{\"port\":\"" + port->get_name() + "\",\"extract\":";
+		latency.extract.append_json(*json);
+		*json += ",\"parse\":";
+		latency.parse.append_json(*json);
+		*json += ",\"fanout\":";
+		latency.fanout.append_json(*json);
+		*json += ",\"write\":";
+		latency.write.append_json(*json);
+		*json += "},";
+	}
+	if(json->back() == ',')
+		json->pop_back();
+
+	*json += "],\"channels\":[";
+	for(auto& channel : channel_latency) {
+		*json += "{\"channel\":\"" + channel.first + "\",\"write\":";
+		channel.second.append_json(*json);
+		*json += "},";
 	}
+	if(json->back() == ',')
+		json->pop_back();
+	*json += "]}";
+
+	in->do_write(json);
+}
+
+/* The stored protobuf, or one built from the columns for a message that
+ * arrived as a raw record.
+ */
+stringp dispatcher::protobuf_of(const history_store::chunk& c, size_t i) {
+	if(c.blob[i])
+		return c.blob[i];
+	auto pb = make_shared<string>();
+	append_flopoint(*pb, history_.name_of(c.name[i]), c.samples_of(i), c.samples_in(i));
+	return pb;
+}
+
+/* Chrome trace JSON of the hot path events still held in every ring. */
+void dispatcher::get_trace(nsp in) {
+	auto json = make_shared<string>();
+	trace::append_chrome_json(*json, port_names_);
+	in->do_write(json);
+}
+
+/* The stored messages are already serialized, so the FloPointMultiMessage is
+ * written out directly: each is field 1, length delimited.
+ */
+void dispatcher::stored_pbs(nsp in) {
+	auto to_send = make_shared<string>();
+
+	history_.for_each([&](const history_store::chunk& c, size_t i) {
+		to_send->push_back(0x0a);
+		append_delimited(*to_send, *protobuf_of(c, i));
+	});
 
-	in->do_write(make_shared<string>(fpmm.SerializeAsString()));
+	in->do_write(to_send);
 }
 
+/* Straight from the sample columns, without a parse. */
 void dispatcher::stored_ascii_waveforms(nsp in) {
 	auto to_send = make_shared<string>();
-	::flopointpb::FloPointMessage fpm;
 
-	for(auto pbs : pbs_locations) {
-			fpm.ParseFromString(*pbs);
-			auto fpwf = make_shared<::flopointpb::FloPointMessage_Waveform>(fpm.waveform());
-			to_send->append(*waveform_ts_ascii(fpwf));
-			fpm.Clear();
-		}
+	history_.for_each([&](const history_store::chunk& c, size_t i) {
+		append_ascii(*to_send, c.samples_of(i), c.samples_in(i));
+	});
 	in->do_write(to_send);
 }
 
-int dispatcher::store_pbs(stringp str_in) {
-	pbs_locations.emplace_back(str_in);
-	while(pbs_locations.size()>max_size)
-		pbs_locations.pop_front();
+/* Lines as on the features channel, for stored messages that have them. */
+void dispatcher::stored_features(nsp in) {
+	auto to_send = make_shared<string>();
 
-	return (max_size - pbs_locations.size());
+	history_.for_each([&](const history_store::chunk& c, size_t i) {
+		if(c.features[i].samples)
+			append_features(*to_send, history_.name_of(c.name[i]), c.features[i]);
+	});
+	in->do_write(to_send);
+}
+
+/* October 18, 2026
+ *
+ * get history <name|all> [since <unix seconds>]
+ *
+ * One line per message, oldest first:
+ * 	name, history seq, unix time, port, then the samples
+ * all tab separated.
+ */
+void dispatcher::get_history(nsp in, arguments args) {
+	bool well_formed = args.size() == 1 || (args.size() == 3 && args[1] == "since");
+	int64_t since = std::numeric_limits<int64_t>::min();
+	if(well_formed && args.size() == 3)
+		well_formed = parse_unix_us(string(args[2].begin(), args[2].end()), since);
+	if(!well_formed) {
+		in->do_write(make_shared<string>(
+				"Usage: get history <name|all> [since <unix seconds>]\n"));
+		return;
+	}
+
+	auto to_send = make_shared<string>();
+	bool all = args[0] == "all";
+	uint32_t id = 0;
+	if(all || history_.find_name(string(args[0].begin(), args[0].end()), id)) {
+		history_.for_each_since(since, [&](const history_store::chunk& c, size_t i) {
+			if(all || c.name[i] == id)
+				append_history(*to_send, c, i);
+		});
+	}
+	in->do_write(to_send);
+}
+
+void dispatcher::append_history(string& out, const history_store::chunk& c, size_t i) {
+	char head[64];
+	int64_t t = c.time[i];
+	snprintf(head, sizeof(head), "\t%llu\t%lld.%06lld\t",
+			(unsigned long long)c.seq(i), (long long)(t / 1000000), (long long)(t % 1000000));
+	out += history_.name_of(c.name[i]);
+	out += head;
+	out += c.port[i] < port_names_.size() ? port_names_[c.port[i]] : "";
+
+	const int32_t* samples = c.samples_of(i);
+	for(size_t j = 0, n = c.samples_in(i) ; j < n ; ++j) {
+		out.push_back('\t');
+		out.append(to_string(samples[j]));
+	}
+	out.push_back('\n');
+}
+
+/* Opens the history file and loads what it holds.  Throws when the file
+ * can't be set up, in which case the history stays in memory only.
+ */
+void dispatcher::persist_history(uint32_t slot_count, uint32_t slot_size) {
+	std::unique_ptr<history_file> file (
+			new history_file(logdir_ + "dewd.history", slot_count, slot_size));
+	file->load(history_, [this](const string& port) { return register_port(port); });
+	history_file_ = std::move(file);
+}
+
+/* The id a serial port's frames carry, from 1 up in the order ports first
+ * appear, opened or named in a reloaded history.  A name keeps its id.
+ */
+uint16_t dispatcher::register_port(const string& name) {
+	auto found = std::find(port_names_.begin(), port_names_.end(), name);
+	if(found != port_names_.end())
+		return static_cast<uint16_t>(found - port_names_.begin());
+	port_names_.push_back(name);
+	return static_cast<uint16_t>(port_names_.size() - 1);
+}
+
+/* Receive time on the wall clock, for stamps taken on the steady clock. */
+int64_t dispatcher::unix_us(time_point<steady_clock> t) {
+	auto wall = boost::chrono::system_clock::now() - (steady_clock::now() - t);
+	return boost::chrono::duration_cast<boost::chrono::microseconds>(
+			wall.time_since_epoch()).count();
+}
+
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Prometheus text exposition.  The whole page is rebuilt off the scrape path
+ * once per interval into a fresh string, and scrapes in progress keep the
+ * page they started with.  Latencies are exported in seconds.
+ */
+
+void dispatcher::set_metrics_timer() {
+	auto self (shared_from_this());
+	metrics_timer_.expires_from_now(metrics_interval_);
+	metrics_timer_.async_wait(bind(&dispatcher::handle_metrics_timeout, self, _1));
+}
+
+void dispatcher::handle_metrics_timeout(const error_code& ec) {
+	if(ec)
+		return;
+	render_metrics();
+	set_metrics_timer();
+}
+
+void dispatcher::render_metrics() {
+	static const struct {
+		const char* name;
+		const char* help;
+		counter message_counter_struct::* field;
+	} message_metrics[] = {
+		{"dewd_messages_received_total", "Frames extracted from the port.",
+				&message_counter_struct::messages_received},
+		{"dewd_messages_sent_total", "Test frames written to the port.",
+				&message_counter_struct::messages_sent},
+		{"dewd_bytes_received_total", "Bytes read from the port.",
+				&message_counter_struct::bytes_received},
+		{"dewd_messages_lost_total", "Frames missing from the sequence.",
+				&message_counter_struct::messages_lost_tot},
+		{"dewd_frame_too_long_total", "Bytes scrubbed from frames that grew too long.",
+				&message_counter_struct::frame_too_long},
+		{"dewd_frame_too_old_total", "Bytes scrubbed from frames left incomplete too long.",
+				&message_counter_struct::frame_too_old},
+		{"dewd_bad_prefix_total", "Bytes scrubbed for a bad frame prefix.",
+				&message_counter_struct::bad_prefix},
+		{"dewd_bad_crc_total", "Bytes scrubbed for a bad prefix crc.",
+				&message_counter_struct::bad_crc},
+		{"dewd_wrapper_bytes_total", "Framing bytes of extracted frames.",
+				&message_counter_struct::wrapper_bytes_tot},
+		{"dewd_message_bytes_total", "Payload bytes of extracted frames.",
+				&message_counter_struct::msg_bytes_tot},
+		{"dewd_garbage_bytes_total", "Bytes scrubbed between frames.",
+				&message_counter_struct::garbage}
+	};
+
+	static const struct {
+		const char* name;
+		int serial_icounter_struct::* field;
+	} uart_metrics[] = {
+		{"rx", &serial_icounter_struct::rx},
+		{"tx", &serial_icounter_struct::tx},
+		{"frame", &serial_icounter_struct::frame},
+		{"overrun", &serial_icounter_struct::overrun},
+		{"parity", &serial_icounter_struct::parity},
+		{"brk", &serial_icounter_struct::brk},
+		{"buf_overrun", &serial_icounter_struct::buf_overrun}
+	};
+
+	static const struct {
+		const char* le;
+		uint64_t ns;
+	} bounds[] = {
+		{"1e-06", 1000}, {"5e-06", 5000}, {"1e-05", 10000}, {"5e-05", 50000},
+		{"0.0001", 100000}, {"0.0005", 500000}, {"0.001", 1000000},
+		{"0.005", 5000000}, {"0.01", 10000000}, {"0.05", 50000000},
+		{"0.1", 100000000}, {"0.5", 500000000}, {"1", 1000000000}
+	};
+
+	auto page = make_shared<string>();
+	page->reserve(metrics_page_->size() + 1024);
+
+	auto family = [&page](const string& name, const char* type, const char* help) {
+		*page += "# HELP " + name + " " + help + "\n";
+		*page += "# TYPE " + name + " " + type + "\n";
+	};
+	auto sample = [&page](const string& name, const string& labels, const string& value) {
+		*page += name + "{" + labels + "} " + value + "\n";
+	};
+	auto histogram = [&](const string& name, const string& labels, const latency_histogram& h) {
+		for(auto& bound : bounds)
+			sample(name + "_bucket", labels + ",le=\"" + bound.le + "\"",
+					to_string(h.count_at_or_below(bound.ns)));
+		sample(name + "_bucket", labels + ",le=\"+Inf\"", to_string(h.count()));
+		sample(name + "_sum", labels, to_string(h.sum() / 1e9));
+		sample(name + "_count", labels, to_string(h.count()));
+	};
+
+	auto ports = serial_ports();
+
+	for(auto& metric : message_metrics) {
+		family(metric.name, "counter", metric.help);
+		for(auto port : ports)
+			sample(metric.name, "port=\"" + port->get_name() + "\"",
+					to_string((int64_t)(port->get_counts().*metric.field)));
+	}
+
+	family("dewd_uart_events_total", "counter", "UART counters from TIOCGICOUNT.");
+	for(auto port : ports) {
+		auto& icount = port->get_icount();
+		for(auto& metric : uart_metrics)
+			sample("dewd_uart_events_total",
+					"port=\"" + port->get_name() + "\",counter=\"" + metric.name + "\"",
+					to_string((unsigned)(icount.*metric.field)));
+	}
+
+	family("dewd_framer_buffered_bytes", "gauge", "Bytes waiting to be framed.");
+	for(auto port : ports)
+		sample("dewd_framer_buffered_bytes", "port=\"" + port->get_name() + "\"",
+				to_string(port->get_buffered()));
+
+	family("dewd_stored_messages", "gauge", "Messages held in the history buffer.");
+	*page += "dewd_stored_messages " + to_string(history_.size()) + "\n";
+
+	if(history_file_) {
+		family("dewd_history_file_skipped_total", "counter",
+				"Messages too large for a slot of the history file.");
+		*page += "dewd_history_file_skipped_total "
+				+ to_string(history_file_->skipped()) + "\n";
+	}
+
+	family("dewd_subscribers", "gauge", "Network sessions subscribed to a channel.");
+	for(auto& channel : subscriptions)
+		sample("dewd_subscribers", "channel=\"" + channel.first + "\"",
+				to_string(subscriber_count(channel.second)));
+
+	family("dewd_network_queued_writes", "gauge",
+			"Writes queued on a network session, including the one in flight.");
+	for(auto session : network)
+		if(session->is_connected())
+			sample("dewd_network_queued_writes", "peer=\"" + session->peer() + "\"",
+					to_string(session->queued()));
+
+	family("dewd_latency_seconds", "histogram",
+			"Time from the read that completed a frame to each later stage.");
+	for(auto port : serial_reading) {
+		auto& latency = port->get_latency();
+		string labels = "port=\"" + port->get_name() + "\",stage=";
+		histogram("dewd_latency_seconds", labels + "\"extract\"", latency.extract);
+		histogram("dewd_latency_seconds", labels + "\"parse\"", latency.parse);
+		histogram("dewd_latency_seconds", labels + "\"fanout\"", latency.fanout);
+		histogram("dewd_latency_seconds", labels + "\"write\"", latency.write);
+	}
+
+	family("dewd_channel_write_latency_seconds", "histogram",
+			"Time from the read that completed a frame to its write on a channel.");
+	for(auto& channel : channel_latency)
+		histogram("dewd_channel_write_latency_seconds",
+				"channel=\"" + channel.first + "\"", channel.second);
+
+	metrics_page_ = page;
 }
 
 
@@ -437,10 +1177,25 @@ void dispatcher::make_branches() {
 			node_fn( bind(&dispatcher::get_help_messages_lost_tot, self, _1))));
 	get_nodes.emplace("ports_for_zabbix", std::make_shared<node>(
 			node_fn( bind(&dispatcher::ports_for_zabbix,self,_1))));
+	get_nodes.emplace("stats", std::make_shared<node>(
+			node_fn( bind(&dispatcher::get_stats,self,_1))));
+	get_nodes.emplace("latency", std::make_shared<node>(
+			node_fn( bind(&dispatcher::get_latency,self,_1))));
+	get_nodes.emplace("trace", std::make_shared<node>(
+			node_fn( bind(&dispatcher::get_trace,self,_1))));
+	for(auto& getter : counter_getters())
+		get_nodes.emplace(getter.first, std::make_shared<node>());
+	for(auto& getter : writer_counter_getters())
+		get_nodes.emplace(getter.first, std::make_shared<node>());
 	get_nodes.emplace("stored_pbs", std::make_shared<node>(
 			node_fn( bind(&dispatcher::stored_pbs,self,_1))));
 	get_nodes.emplace("stored_ascii_waveforms", std::make_shared<node>(
 			node_fn( bind(&dispatcher::stored_ascii_waveforms,self,_1))));
+	get_nodes.emplace("stored_features", std::make_shared<node>(
+			node_fn( bind(&dispatcher::stored_features,self,_1))));
+	auto history = std::make_shared<node>();
+	history->set_args(arg_fn( bind(&dispatcher::get_history,self,_1,_2)));
+	get_nodes.emplace("history", history);
 
 	subscribe_nodes.emplace("help", std::make_shared<node>(
 			node_fn( bind(&dispatcher::subscribe_help, self, _1))));
@@ -453,11 +1208,10 @@ void dispatcher::make_branches() {
 			node_fn( bind(&dispatcher::unsubscribe_help, self, _1))));
 
 
-	for(auto channel : subscriptions) {
-		subscribe_nodes["to"]->spawn(
-				channel.first,
-				make_shared<node>(
-						node_fn( bind(&dispatcher::subscribe, self, _1, channel.first))));
+	for(auto& channel : subscriptions) {
+		auto leaf = make_shared<node>();
+		leaf->set_args(arg_fn( bind(&dispatcher::subscribe, self, _1, channel.first, _2)));
+		subscribe_nodes["to"]->spawn(channel.first, leaf);
 		unsubscribe_nodes["from"]->spawn(
 				channel.first,
 				make_shared<node>(
@@ -479,6 +1233,11 @@ void dispatcher::make_leaves() {
 			port->get_name(),
 			make_shared<node>(
 					node_fn( bind(&ss::get_messages_lost_tot,port,_1))));
+		for(auto& getter : counter_getters())
+			get_nodes[getter.first]->spawn(
+				port->get_name(),
+				make_shared<node>(
+						node_fn( bind(&dispatcher::reply, _1, port, getter.second))));
 	}
 
 	for(auto port : serial_writing) {
@@ -486,10 +1245,49 @@ void dispatcher::make_leaves() {
 			port->get_name(),
 			make_shared<node>(
 					node_fn( bind(&ss::get_tx,port,_1))));
+		for(auto& getter : writer_counter_getters())
+			get_nodes[getter.first]->spawn(
+				port->get_name(),
+				make_shared<node>(
+						node_fn( bind(&dispatcher::reply, _1, port, getter.second))));
 	}
 
 }
 
+/* Counters of reading ports that are served as get <counter> <port>. */
+const vector<pair<string,ss_getter> >& dispatcher::counter_getters() {
+	static const vector<pair<string,ss_getter> > getters = {
+			{"frame_too_old", &ss::get_frame_too_old},
+			{"frame_too_long", &ss::get_frame_too_long},
+			{"bad_prefix", &ss::get_bad_prefix},
+			{"bad_crc", &ss::get_bad_crc},
+			{"bytes_received", &ss::get_bytes_received},
+			{"msg_bytes_tot", &ss::get_msg_bytes_tot},
+			{"wrapper_bytes_tot", &ss::get_wrapper_bytes_tot},
+			{"garbage", &ss::get_garbage},
+			{"rx_rate", &ss::get_rx_rate},
+			{"overrun_rate", &ss::get_overrun_rate},
+			{"frame_rate", &ss::get_frame_rate},
+			{"byte_rate", &ss::get_byte_rate},
+			{"loss_rate", &ss::get_loss_rate}
+	};
+	return getters;
+}
+
+/* The same for writing ports, some of which never read. */
+const vector<pair<string,ss_getter> >& dispatcher::writer_counter_getters() {
+	static const vector<pair<string,ss_getter> > getters = {
+			{"messages_sent_tot", &ss::get_messages_sent_tot},
+			{"tx_rate", &ss::get_tx_rate}
+	};
+	return getters;
+}
+
+/* Answers with a single counter of a single port. */
+void dispatcher::reply(nsp in, ssp port, ss_getter getter) {
+	in->do_write(make_shared<string>(((*port).*getter)()));
+}
+
 /*=============================================================================
  * December 16, 2015
  *
@@ -541,7 +1339,18 @@ void dispatcher::help_get(nsp in) {
 }
 
 void dispatcher::subscribe_help(nsp in) {
-	string to_write ("subscribe_help() called.\n");
+	string to_write ("Usage: subscribe to <channel> [every <n>] [stamped] [delimited]"
+			" [from <seq> | since <unix seconds>]\n");
+	to_write += "every <n> sends one message in n.  stamped puts a line\n"
+			"  #<channel seq>\\t<history seq>\\t<unix seconds>\\t<bytes>\n"
+			"ahead of each message.  delimited, on protobuf_all only, puts each\n"
+			"message's varint length ahead of it, as writeDelimitedTo does.\n"
+			"compressed_waveforms takes no every; its format is described in\n"
+			"waveform_codec.h.\n"
+			"from and since first replay the history\n"
+			"from that seq or time, then carry on live.  Channels:\n";
+	for(auto& channel : subscriptions)
+		to_write += "  " + channel.first + "\n";
 	in->do_write(make_shared<string>(to_write));
 }
 
@@ -8,19 +8,32 @@
 #ifndef STRUCTS_H_
 #define STRUCTS_H_
 
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
 #include <memory>
 #include <vector>
+#include <string>
 
 #include <boost/asio.hpp>
 #include <boost/chrono.hpp>
 #include <boost/chrono/time_point.hpp>
 
+#include "histogram.h"
+#include "trace.h"
+#include "waveform_features.h"
+#include "history.h"
+#include "history_file.h"
+#include "wire.h"
+#include "waveform_codec.h"
 
 using ::std::shared_ptr;
 using ::boost::asio::io_service;
 using ::boost::chrono::time_point;
 using ::boost::chrono::steady_clock;
 using ::std::vector;
+using ::std::string;
 
 namespace dew {
 
@@ -62,20 +75,108 @@ struct serial_icounter_struct {
 };
 
 
+/* October 18, 2026
+ *
+ * A 64 bit counter that may be read from any thread while its owner updates
+ * it.  Each counter has a single writer, the io thread of its session, so an
+ * update is a relaxed load and store rather than a locked read-modify-write.
+ */
+class counter {
+public:
+	counter() : value_(0) {}
+	counter(const counter&) = delete;
+	counter& operator=(const counter&) = delete;
+
+	operator int64_t() const { return value_.load(std::memory_order_relaxed); }
+
+	counter& operator=(int64_t n) {
+		value_.store(n, std::memory_order_relaxed);
+		return *this;
+	}
+	counter& operator+=(int64_t n) { return *this = *this + n; }
+	counter& operator-=(int64_t n) { return *this = *this - n; }
+	counter& operator++() { return *this += 1; }
+
+private:
+	std::atomic<int64_t> value_;
+};
+
+
+/* A rate measured over the last sample window, alongside an exponentially
+ * weighted moving average of those windows.  Written by the sampling timer and
+ * readable from any thread.
+ */
+class rate_gauge {
+public:
+	rate_gauge() : window_(0), ewma_(0), primed_(false) {}
+
+	/* tau is the time constant of the average, in the same units as dt. */
+	void update(double rate, double dt, double tau) {
+		window_.store(rate, std::memory_order_relaxed);
+		double alpha = 1.0 - std::exp(-dt / tau);
+		double avg = primed_ ? ewma() + alpha * (rate - ewma()) : rate;
+		ewma_.store(avg, std::memory_order_relaxed);
+		primed_ = true;
+	}
+
+	double window() const { return window_.load(std::memory_order_relaxed); }
+	double ewma() const { return ewma_.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<double> window_;
+	std::atomic<double> ewma_;
+	bool primed_;
+};
+
+
 struct message_counter_struct {
-	int messages_received;
-	int messages_sent;
-	int bytes_received;
-	int last_msg;
-	int curr_msg;
-	int messages_lost_tot;
-	int frame_too_long;
-	int frame_too_old;
-	int bad_prefix;
-	int bad_crc;
-	int wrapper_bytes_tot;
-	int msg_bytes_tot;
-	int garbage;
+	counter messages_received;
+	counter messages_sent;
+	counter bytes_received;
+	counter last_msg;
+	counter curr_msg;
+	counter messages_lost_tot;
+	counter frame_too_long;
+	counter frame_too_old;
+	counter bad_prefix;
+	counter bad_crc;
+	counter wrapper_bytes_tot;
+	counter msg_bytes_tot;
+	counter garbage;
+};
+
+struct message_rate_struct {
+	rate_gauge frames;
+	rate_gauge bytes;
+	rate_gauge lost;
+};
+
+/* October 18, 2026
+ *
+ * Latency from the read completion that finished a frame to each later stage
+ * of its trip through dewd, in nanoseconds.
+ */
+struct port_latency_struct {
+	latency_histogram extract;
+	latency_histogram parse;
+	latency_histogram fanout;
+	latency_histogram write;
+};
+
+/* Travels with a frame from the serial session to the dispatcher. */
+struct frame_stamp {
+	time_point<steady_clock> read;
+	port_latency_struct* port;
+	uint16_t port_id;
+};
+
+/* Travels with a write through a network session's queue.  Null histograms
+ * mean the write isn't timed.
+ */
+struct write_stamp {
+	time_point<steady_clock> read;
+	latency_histogram* channel;
+	latency_histogram* port;
 };
 
 struct write_test_struct {
@@ -83,8 +184,51 @@ struct write_test_struct {
 	double max_c;
 	int sample_size;
 	double peak;
+
+	/* October 18, 2026 :: load generator profile
+	 *
+	 * rate is the target number of frames per second, with 0 meaning the
+	 * original unpaced loop.  burst frames are written back to back on each
+	 * tick, so ticks occur every burst/rate seconds.  Each frame carries between
+	 * min_samples and max_samples waveform samples and a name drawn from names,
+	 * where an entry of the form name:weight is drawn with relative weight.
+	 *
+	 * The remaining members are per-frame probabilities of deliberate
+	 * corruption, each aimed at one of the framer's failure counters.
+	 */
+	double rate;
+	int burst;
+	int min_samples;
+	int max_samples;
+	vector<string> names;
+	double p_bad_crc;
+	double p_bad_prefix;
+	double p_truncated;
+	double p_garbage;
+	double p_lost;
+
+	/* Base seed for the per-port generators; 0 seeds from the clock. */
+	unsigned long long seed;
+
+	/* October 18, 2026 :: raw records instead of FloPointMessages. */
+	bool raw_payload;
 };
 
+/* October 18, 2026 :: one entry of names, as name or name:weight.  A name
+ * without a weight weighs 1.  False when the weight is not a number.
+ */
+inline bool parse_name_weight(const std::string& entry, std::string& name, double& weight) {
+	auto pos = entry.find(':');
+	name = entry.substr(0, pos);
+	weight = 1.0;
+	if(pos == std::string::npos)
+		return true;
+	std::string text = entry.substr(pos+1);
+	char* end = nullptr;
+	weight = std::strtod(text.c_str(), &end);
+	return !text.empty() && *end == '\0';
+}
+
 } //namespace dew
 
 #endif /* STRUCTS_H_ */
@@ -0,0 +1,231 @@
+/*
+ * trace.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <string>
+#include <vector>
+
+#ifdef DEWD_TRACING
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <boost/chrono.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Hot path tracing.  Build with -DDEWD_TRACING to turn it on.  Without it
+ * nothing here is compiled but an append_chrome_json that writes an empty
+ * document, and every DEWD_TRACE macro expands to nothing.
+ *
+ * Each thread appends 24 byte events to its own ring and only that thread
+ * writes to it, so an event costs an rdtsc, a copy into the slot and a
+ * release store of the head.  A dump copies every ring and throws away any slot the
+ * writer may have lapped while the copy was being made.
+ */
+
+#ifdef DEWD_TRACING
+#define DEWD_TRACE(event, port, size) \
+	::dew::trace::emit(::dew::trace::event, 'i', (port), (size))
+#define DEWD_TRACE_SCOPE(event, port, size) \
+	::dew::trace::scope dewd_trace_scope_ (::dew::trace::event, (port), (size))
+#else
+#define DEWD_TRACE(event, port, size) ((void)0)
+#define DEWD_TRACE_SCOPE(event, port, size) ((void)0)
+#endif
+
+
+namespace dew {
+namespace trace {
+
+#ifdef DEWD_TRACING
+
+enum event_id : uint16_t {
+	ss_do_read,
+	ss_handle_read,
+	ss_check_the_deque,
+	dispatcher_forward,
+	ns_do_write,
+	event_count
+};
+
+inline const char* event_name(uint16_t id) {
+	static const char* names[event_count] = {
+		"ss::do_read",
+		"ss::handle_read",
+		"ss::check_the_deque",
+		"dispatcher::forward",
+		"ns::do_write"
+	};
+	return id < event_count ? names[id] : "unknown";
+}
+
+struct event {
+	uint64_t tsc;
+	uint16_t id;
+	uint16_t port;
+	char phase;
+	uint32_t size;
+};
+
+inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+			boost::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+class ring {
+public:
+	static const uint64_t CAPACITY = 1 << 16;
+
+	ring() : head_(0), events_(CAPACITY) {}
+
+	void push(const event& e) {
+		uint64_t head = head_.load(std::memory_order_relaxed);
+		events_[head & (CAPACITY - 1)] = e;
+		head_.store(head + 1, std::memory_order_release);
+	}
+
+	/* Appends the events still held, oldest first. */
+	void copy_to(std::vector<event>& out) const {
+		uint64_t head = head_.load(std::memory_order_acquire);
+		uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+		size_t start = out.size();
+		for(uint64_t i = first ; i < head ; ++i)
+			out.push_back(events_[i & (CAPACITY - 1)]);
+
+		/* Slots the writer reached during the copy may be torn. */
+		uint64_t after = head_.load(std::memory_order_acquire);
+		uint64_t lapped = after + 1 > CAPACITY ? after + 1 - CAPACITY : 0;
+		if(lapped > first)
+			out.erase(out.begin() + start,
+					out.begin() + start + std::min<uint64_t>(lapped - first, head - first));
+	}
+
+private:
+	std::atomic<uint64_t> head_;
+	std::vector<event> events_;
+};
+
+/* Every ring ever created.  The lock is taken when a thread first traces
+ * and on a dump.
+ */
+struct registry {
+	std::mutex lock;
+	std::vector<std::unique_ptr<ring> > rings;
+	uint64_t tsc0 = now();
+	boost::chrono::steady_clock::time_point t0 = boost::chrono::steady_clock::now();
+
+	static registry& get() {
+		static registry r;
+		return r;
+	}
+};
+
+inline ring& local_ring() {
+	static thread_local ring* mine = nullptr;
+	if(!mine) {
+		auto& r = registry::get();
+		std::lock_guard<std::mutex> hold (r.lock);
+		r.rings.emplace_back(new ring);
+		mine = r.rings.back().get();
+	}
+	return *mine;
+}
+
+inline void emit(uint16_t id, char phase, uint16_t port, uint32_t size) {
+	local_ring().push(event{now(), id, port, phase, size});
+}
+
+class scope {
+public:
+	scope(uint16_t id, uint16_t port, uint32_t size) : id_(id), port_(port) {
+		emit(id_, 'B', port_, size);
+	}
+	~scope() { emit(id_, 'E', port_, 0); }
+
+private:
+	uint16_t id_;
+	uint16_t port_;
+};
+
+/* Chrome's trace event format, loadable in chrome://tracing or Perfetto.
+ * Timestamps are microseconds since the registry was created.  Events name
+ * their port by id, an index into ports.
+ */
+inline void append_chrome_json(std::string& out, const std::vector<std::string>& ports) {
+	out += "{\"traceEvents\":[";
+
+	auto& r = registry::get();
+	std::vector<std::vector<event> > copies;
+	double ticks_per_us = 1;
+	{
+		std::lock_guard<std::mutex> hold (r.lock);
+		for(auto& each : r.rings) {
+			copies.emplace_back();
+			each->copy_to(copies.back());
+		}
+
+		double us = boost::chrono::duration<double, boost::micro>(
+				boost::chrono::steady_clock::now() - r.t0).count();
+		if(us > 0)
+			ticks_per_us = (now() - r.tsc0) / us;
+	}
+
+	bool first = true;
+	for(size_t tid = 0 ; tid < copies.size() ; ++tid)
+		for(auto& e : copies[tid]) {
+			if(!first)
+				out += ',';
+			first = false;
+			out += "{\"name\":\"";
+			out += event_name(e.id);
+			out += "\",\"ph\":\"";
+			out += e.phase;
+			out += "\",\"ts\":";
+			out += std::to_string((e.tsc - r.tsc0) / ticks_per_us);
+			out += ",\"pid\":1,\"tid\":";
+			out += std::to_string(tid);
+			if(e.phase == 'i')
+				out += ",\"s\":\"t\"";
+			if(e.phase != 'E') {
+				out += ",\"args\":{\"port\":\"";
+				out += e.port < ports.size() ? ports[e.port] : "";
+				out += "\",\"size\":";
+				out += std::to_string(e.size);
+				out += '}';
+			}
+			out += '}';
+		}
+	out += "]}";
+}
+
+#else
+
+inline void append_chrome_json(std::string& out, const std::vector<std::string>&) {
+	out += "{\"traceEvents\":[],\"otherData\":{\"note\":\"built without DEWD_TRACING\"}}";
+}
+
+#endif
+
+} // trace namespace
+} // dew namespace
+
+#endif /* TRACE_H_ */
@@ -14,31 +14,46 @@
 #include <boost/bimap.hpp>
 #include <boost/bimap/unordered_multiset_of.hpp>
 
+#include <boost/utility/string_ref.hpp>
+#include <boost/range/iterator_range.hpp>
+
 
 namespace dew {
 
 class serial_session;
 class network_session;
+class metrics_session;
 class node;
 
 typedef serial_session ss;
 typedef network_session ns;
 typedef ::std::shared_ptr<ss> ssp;
 typedef ::std::shared_ptr<ns> nsp;
+typedef ::std::shared_ptr<metrics_session> msp;
 typedef ::std::shared_ptr<node> nodep;
 
 typedef uint8_t u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
+typedef uint64_t u64;
 typedef ::std::deque<u8> pBuff;
 typedef ::std::vector<u8> bBuff;
 typedef ::std::shared_ptr<bBuff> bBuffp;
 typedef ::std::shared_ptr<pBuff> pBuffp;
 
-typedef ::std::deque<::std::string> sentence;
+/* Words of a network request are views into the session's receive buffer and
+ * are only valid until the next read completes.
+ */
+typedef ::boost::string_ref word;
+typedef ::std::vector<word> sentence;
 typedef ::std::shared_ptr<::std::string> stringp;
 
+/* The words left over once a command has been matched. */
+typedef ::boost::iterator_range<sentence::const_iterator> arguments;
+
 typedef ::std::function<void(nsp)> node_fn;
+typedef ::std::function<void(nsp, arguments)> arg_fn;
+typedef ::std::string (serial_session::*ss_getter)();
 
 }; // namespace dew
 
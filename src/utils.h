@@ -21,6 +21,7 @@
 #include <sstream>
 
 #include <cctype>
+#include <cstdint>
 #include <ios>
 
 #include <boost/range/adaptors.hpp>
@@ -194,6 +195,93 @@ u8 crc8( Range rng ) {
 
 
 
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Request tokenizing.  Words are views into the caller's buffer, so nothing
+ * is copied and a reused sentence never allocates once it has grown.  Blanks
+ * are looked up in a table rather than through the locale-aware isspace.
+ */
+
+inline bool is_blank(char c) {
+	static const struct blank_table {
+		bool blank[256];
+		blank_table() : blank() {
+			for(u8 c : {' ', '\t', '\r', '\n', '\v', '\f', '\0'})
+				blank[c] = true;
+		}
+	} table;
+	return table.blank[static_cast<u8>(c)];
+}
+
+template<typename Sentence>
+void tokenize(const char* first, const char* last, Sentence& out) {
+	out.clear();
+	while(first != last) {
+		while(first != last && is_blank(*first))
+			++first;
+		const char* start = first;
+		while(first != last && !is_blank(*first))
+			++first;
+		if(start != first)
+			out.emplace_back(start, first - start);
+	}
+}
+
+
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * xoshiro256** by Blackman and Vigna, seeded through splitmix64 as its
+ * authors recommend.  Each test port owns one of these so that ports never
+ * share generator state, and a fixed seed reproduces a port's output exactly.
+ */
+
+inline u64 splitmix64(u64& state) {
+	u64 z = (state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+class xoshiro256ss {
+public:
+	typedef u64 result_type;
+
+	explicit xoshiro256ss(u64 seed = 0) { reseed(seed); }
+
+	void reseed(u64 seed) {
+		for(auto& word : s_)
+			word = splitmix64(seed);
+	}
+
+	u64 operator()() {
+		const u64 result = rotl(s_[1] * 5, 7) * 9;
+		const u64 t = s_[1] << 17;
+		s_[2] ^= s_[0];
+		s_[3] ^= s_[1];
+		s_[1] ^= s_[2];
+		s_[0] ^= s_[3];
+		s_[2] ^= t;
+		s_[3] = rotl(s_[3], 45);
+		return result;
+	}
+
+	static constexpr u64 min() { return 0; }
+	static constexpr u64 max() { return ~u64(0); }
+
+	/* Uniform on [0,1) from the top 53 bits. */
+	double uniform() { return ((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+	static u64 rotl(const u64 x, int k) { return (x << k) | (x >> (64 - k)); }
+
+	u64 s_[4];
+};
+
+
+
 /*-----------------------------------------------------------------------------
  * November 27, 2015
  *
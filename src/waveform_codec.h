@@ -0,0 +1,318 @@
+/*
+ * waveform_codec.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef WAVEFORM_CODEC_H_
+#define WAVEFORM_CODEC_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "wire.h"
+
+
+namespace dew {
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * The compressed_waveforms format.
+ *
+ * A subscriber gets a stream of records, one per waveform:
+ *
+ *   varint   length of the rest of the record
+ *   u8       flags: bit 0 keyframe, bits 1 and 2 the predictor
+ *   varint   name id
+ *   keyframe only:
+ *   varint   name length, then the name
+ *   varint   sample count n
+ *   n > 0 only:
+ *   varint   the first residual, zigzagged
+ *            the other n-1 residuals, zigzagged, in blocks of BLOCK
+ *
+ * Each block is a byte holding the bit width b of its largest value (0 to
+ * 32) followed by its values packed b bits each, least significant bit
+ * first, into ceil(count * b / 8) bytes.  Only the last block is short.
+ *
+ * The residuals are what is left of each sample s[i] after a prediction:
+ *
+ *   0  previous sample    s[i] - s[i-1]
+ *   1  slope              s[i] - 2 s[i-1] + s[i-2], s[1] - s[0] at i = 1
+ *   2  previous waveform  d[i] - d[i-1], where d[i] = s[i] - p[i] and p is
+ *                         the last waveform with the same name id
+ *
+ * with s[-1] and d[-1] zero, so the first residual is s[0] or d[0].  The
+ * arithmetic wraps at 32 bits.  Predictor 2 is only used when p has as many
+ * samples as s, and never on a keyframe.  zigzag(x) is (x << 1) ^ (x >> 31),
+ * which keeps small negative residuals small.
+ *
+ * A keyframe gives a name its id and refers to nothing sent before it.  Ids
+ * count up from 0 in the order names first appear.  Every name's first record
+ * is a keyframe, and so is every KEYFRAME_INTERVAL'th after it.  The encoder
+ * tries every predictor it may use and keeps the one that packs smallest.
+ *
+ * The encoder may start over at any time, always on a keyframe: a reused id
+ * then names whatever its new keyframe says.  waveform_decoder is the
+ * reference reader.
+ */
+
+namespace codec_detail {
+
+const size_t BLOCK = 16;
+const unsigned PREDICTORS = 3;
+
+inline uint32_t zigzag(uint32_t x) {
+	return (x << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(x) >> 31);
+}
+
+inline uint32_t unzigzag(uint32_t z) {
+	return (z >> 1) ^ (0 - (z & 1));
+}
+
+inline unsigned width(uint32_t x) {
+	return x ? 32 - __builtin_clz(x) : 0;
+}
+
+inline size_t varint_size(uint64_t n) {
+	size_t size = 1;
+	for( ; n >= 0x80 ; n >>= 7)
+		++size;
+	return size;
+}
+
+/* The zigzagged residuals of s under predictor, previous for predictor 2. */
+inline void residuals(unsigned predictor, const int32_t* s, const int32_t* previous,
+		size_t n, uint32_t* r) {
+	auto u = reinterpret_cast<const uint32_t*>(s);
+	auto p = reinterpret_cast<const uint32_t*>(previous);
+	switch(predictor) {
+	case 0:
+		r[0] = zigzag(u[0]);
+		for(size_t i = 1 ; i < n ; ++i)
+			r[i] = zigzag(u[i] - u[i-1]);
+		break;
+	case 1:
+		r[0] = zigzag(u[0]);
+		if(n > 1)
+			r[1] = zigzag(u[1] - u[0]);
+		for(size_t i = 2 ; i < n ; ++i)
+			r[i] = zigzag(u[i] - 2 * u[i-1] + u[i-2]);
+		break;
+	default:
+		r[0] = zigzag(u[0] - p[0]);
+		for(size_t i = 1 ; i < n ; ++i)
+			r[i] = zigzag((u[i] - p[i]) - (u[i-1] - p[i-1]));
+		break;
+	}
+}
+
+/* Bytes the residuals take once packed, and each block's width in widths. */
+inline size_t packed_size(const uint32_t* r, size_t n, unsigned char* widths) {
+	size_t size = varint_size(r[0]);
+	for(size_t at = 1, k = 0 ; at < n ; at += BLOCK, ++k) {
+		size_t count = n - at < BLOCK ? n - at : BLOCK;
+		uint32_t any = 0;
+		for(size_t i = 0 ; i < count ; ++i)
+			any |= r[at + i];
+		widths[k] = width(any);
+		size += 1 + (count * widths[k] + 7) / 8;
+	}
+	return size;
+}
+
+inline void pack(std::string& out, const uint32_t* r, size_t n, const unsigned char* widths) {
+	append_varint(out, r[0]);
+	for(size_t at = 1, k = 0 ; at < n ; at += BLOCK, ++k) {
+		size_t count = n - at < BLOCK ? n - at : BLOCK;
+		unsigned b = widths[k];
+		out.push_back(static_cast<char>(b));
+		uint64_t bits = 0;
+		unsigned held = 0;
+		for(size_t i = 0 ; i < count ; ++i) {
+			bits |= uint64_t(r[at + i]) << held;
+			held += b;
+			for( ; held >= 8 ; held -= 8, bits >>= 8)
+				out.push_back(static_cast<char>(bits & 0xff));
+		}
+		if(held)
+			out.push_back(static_cast<char>(bits & 0xff));
+	}
+}
+
+/* False when the blocks run past end or a width is over 32. */
+inline bool unpack(const uint8_t*& p, const uint8_t* end, size_t n, uint32_t* r) {
+	uint64_t first;
+	if(!read_varint(p, end, first) || first > 0xffffffffULL)
+		return false;
+	r[0] = static_cast<uint32_t>(first);
+	for(size_t at = 1 ; at < n ; at += BLOCK) {
+		size_t count = n - at < BLOCK ? n - at : BLOCK;
+		if(p >= end || *p > 32)
+			return false;
+		unsigned b = *p++;
+		size_t bytes = (count * b + 7) / 8;
+		if(size_t(end - p) < bytes)
+			return false;
+		uint64_t mask = (uint64_t(1) << b) - 1;
+		uint64_t bits = 0;
+		unsigned held = 0;
+		for(size_t i = 0 ; i < count ; ++i) {
+			for( ; held < b ; held += 8)
+				bits |= uint64_t(*p++) << held;
+			r[at + i] = static_cast<uint32_t>(bits & mask);
+			bits >>= b;
+			held -= b;
+		}
+	}
+	return true;
+}
+
+} // codec_detail namespace
+
+class waveform_encoder {
+public:
+	static const unsigned KEYFRAME_INTERVAL = 64;
+
+	/* Forgets every name, so each one's next record is a keyframe. */
+	void reset() { names_.clear(); }
+
+	/* Appends one record for the waveform to out. */
+	void encode(std::string& out, const std::string& name, const int32_t* s, size_t n) {
+		using namespace codec_detail;
+
+		auto found = names_.find(name);
+		bool key = found == names_.end() || found->second.since_key >= KEYFRAME_INTERVAL;
+		if(found == names_.end())
+			found = names_.emplace(name, reference{uint32_t(names_.size()), 0, {}}).first;
+		reference& ref = found->second;
+
+		unsigned best = 0;
+		size_t best_size = 0;
+		size_t blocks = n > 1 ? (n - 2) / BLOCK + 1 : 0;
+		for(unsigned k = 0 ; k < PREDICTORS ; ++k) {
+			residuals_[k].resize(n);
+			widths_[k].resize(blocks);
+		}
+		if(n) {
+			for(unsigned k = 0 ; k < PREDICTORS ; ++k) {
+				if(k == 2 && (key || ref.samples.size() != n))
+					break;
+				residuals(k, s, ref.samples.data(), n, residuals_[k].data());
+				size_t size = packed_size(residuals_[k].data(), n, widths_[k].data());
+				if(k == 0 || size < best_size) {
+					best = k;
+					best_size = size;
+				}
+			}
+		}
+
+		body_.clear();
+		body_.push_back(static_cast<char>((key ? 1 : 0) | best << 1));
+		append_varint(body_, ref.id);
+		if(key) {
+			append_varint(body_, name.size());
+			body_.append(name);
+		}
+		append_varint(body_, n);
+		if(n)
+			pack(body_, residuals_[best].data(), n, widths_[best].data());
+		append_varint(out, body_.size());
+		out.append(body_);
+
+		ref.since_key = key ? 1 : ref.since_key + 1;
+		ref.samples.assign(s, s + n);
+	}
+
+private:
+	struct reference {
+		uint32_t id;
+		uint32_t since_key;
+		std::vector<int32_t> samples;
+	};
+
+	std::unordered_map<std::string, reference> names_;
+	std::vector<uint32_t> residuals_[codec_detail::PREDICTORS];
+	std::vector<unsigned char> widths_[codec_detail::PREDICTORS];
+	std::string body_;
+};
+
+class waveform_decoder {
+public:
+	/* Reads the record at p and moves p past it.  False when the record is
+	 * malformed or refers to a name or waveform this decoder hasn't seen.
+	 */
+	bool decode(const uint8_t*& p, const uint8_t* end, std::string& name,
+			std::vector<int32_t>& out) {
+		using namespace codec_detail;
+
+		uint64_t length, id, n;
+		if(!read_varint(p, end, length) || length > uint64_t(end - p))
+			return false;
+		const uint8_t* record_end = p + length;
+		if(p >= record_end)
+			return false;
+		unsigned flags = *p++;
+		bool key = flags & 1;
+		unsigned predictor = flags >> 1;
+		if(flags > 5 || !read_varint(p, record_end, id) || id > names_.size())
+			return false;
+
+		if(key) {
+			uint64_t name_size;
+			if(!read_varint(p, record_end, name_size) || name_size > uint64_t(record_end - p)
+					|| predictor == 2)
+				return false;
+			if(id == names_.size()) {
+				names_.emplace_back();
+				previous_.emplace_back();
+			}
+			names_[id].assign(reinterpret_cast<const char*>(p), name_size);
+			p += name_size;
+		} else if(id == names_.size())
+			return false;
+
+		if(!read_varint(p, record_end, n) || n > uint64_t(record_end - p) * BLOCK + 1)
+			return false;
+		std::vector<int32_t>& previous = previous_[id];
+		if(predictor == 2 && previous.size() != n)
+			return false;
+
+		residuals_.resize(n);
+		out.resize(n);
+		if(n && !unpack(p, record_end, n, residuals_.data()))
+			return false;
+		if(p != record_end)
+			return false;
+
+		auto s = reinterpret_cast<uint32_t*>(out.data());
+		auto q = reinterpret_cast<const uint32_t*>(previous.data());
+		for(size_t i = 0 ; i < n ; ++i) {
+			uint32_t r = unzigzag(residuals_[i]);
+			if(predictor == 0)
+				s[i] = i ? s[i-1] + r : r;
+			else if(predictor == 1)
+				s[i] = i > 1 ? 2 * s[i-1] - s[i-2] + r : i ? s[0] + r : r;
+			else
+				s[i] = q[i] + (i ? s[i-1] - q[i-1] + r : r);
+		}
+
+		name = names_[id];
+		previous.assign(out.begin(), out.end());
+		return true;
+	}
+
+private:
+	std::vector<std::string> names_;
+	std::vector<std::vector<int32_t> > previous_;
+	std::vector<uint32_t> residuals_;
+};
+
+} // dew namespace
+
+#endif /* WAVEFORM_CODEC_H_ */
@@ -0,0 +1,188 @@
+/*
+ * waveform_features.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef WAVEFORM_FEATURES_H_
+#define WAVEFORM_FEATURES_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DEWD_HAVE_AVX2_KERNEL
+#endif
+
+
+namespace dew {
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Per waveform features, worked out once after parse so that clients don't
+ * each redo it from the samples.
+ *
+ *  peak, argmax  largest sample and the first index holding it
+ *  baseline      mean of the first eighth of the waveform (at least 1 sample)
+ *  integral      sum of the samples above baseline
+ *  rise          samples between the 10% and 90% crossings of the leading
+ *                edge, found walking back from argmax, linearly interpolated
+ *
+ * The pass over every sample (peak, argmax and sum) has an AVX2 kernel chosen
+ * at run time, with a scalar fallback.  The rest looks at a handful of
+ * samples and stays scalar.  samples is zero for a message that was never
+ * analysed.
+ */
+
+struct waveform_features {
+	int32_t peak;
+	uint32_t argmax;
+	uint32_t samples;
+	double baseline;
+	double integral;
+	double rise;
+};
+
+namespace features_detail {
+
+inline void scan_scalar(const int32_t* w, size_t n,
+		int32_t& peak, uint32_t& argmax, int64_t& sum) {
+	peak = w[0];
+	argmax = 0;
+	sum = 0;
+	for(size_t i = 0 ; i < n ; ++i) {
+		if(w[i] > peak) {
+			peak = w[i];
+			argmax = i;
+		}
+		sum += w[i];
+	}
+}
+
+#ifdef DEWD_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+inline void scan_avx2(const int32_t* w, size_t n,
+		int32_t& peak, uint32_t& argmax, int64_t& sum) {
+	size_t body = n & ~size_t(7);
+	if(body == 0) {
+		scan_scalar(w, n, peak, argmax, sum);
+		return;
+	}
+
+	__m256i top = _mm256_set1_epi32(w[0]);
+	__m256i total = _mm256_setzero_si256();
+	for(size_t i = 0 ; i < body ; i += 8) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+		top = _mm256_max_epi32(top, v);
+		total = _mm256_add_epi64(total,
+				_mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+		total = _mm256_add_epi64(total,
+				_mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+	}
+
+	int32_t lanes[8];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), top);
+	int64_t sums[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), total);
+
+	peak = lanes[0];
+	for(int i = 1 ; i < 8 ; ++i)
+		if(lanes[i] > peak)
+			peak = lanes[i];
+	sum = sums[0] + sums[1] + sums[2] + sums[3];
+	for(size_t i = body ; i < n ; ++i) {
+		if(w[i] > peak)
+			peak = w[i];
+		sum += w[i];
+	}
+
+	/* First index holding the peak. */
+	__m256i wanted = _mm256_set1_epi32(peak);
+	argmax = 0;
+	size_t i = 0;
+	for( ; i < body ; i += 8) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i));
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, wanted)));
+		if(mask) {
+			argmax = i + __builtin_ctz(mask);
+			return;
+		}
+	}
+	for( ; i < n ; ++i)
+		if(w[i] == peak) {
+			argmax = i;
+			return;
+		}
+}
+#endif
+
+inline bool use_avx2() {
+#ifdef DEWD_HAVE_AVX2_KERNEL
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+#else
+	return false;
+#endif
+}
+
+/* Where the edge rising into index i crosses level, as a fractional index. */
+inline double crossing(const int32_t* w, size_t i, double level) {
+	double below = w[i-1], above = w[i];
+	return above > below ? (i - 1) + (level - below) / (above - below) : i;
+}
+
+} // features_detail namespace
+
+inline waveform_features compute_features(const int32_t* w, size_t n) {
+	waveform_features f {0, 0, static_cast<uint32_t>(n), 0, 0, 0};
+	if(n == 0)
+		return f;
+
+	int64_t sum;
+	if(features_detail::use_avx2())
+		features_detail::scan_avx2(w, n, f.peak, f.argmax, sum);
+	else
+		features_detail::scan_scalar(w, n, f.peak, f.argmax, sum);
+
+	size_t head = n / 8 ? n / 8 : 1;
+	int64_t head_sum = 0;
+	for(size_t i = 0 ; i < head ; ++i)
+		head_sum += w[i];
+	f.baseline = static_cast<double>(head_sum) / head;
+	f.integral = sum - f.baseline * n;
+
+	double amplitude = f.peak - f.baseline;
+	if(amplitude <= 0)
+		return f;
+
+	double lo = f.baseline + 0.1 * amplitude;
+	double hi = f.baseline + 0.9 * amplitude;
+	size_t i = f.argmax;
+	while(i > 0 && w[i-1] >= hi)
+		--i;
+	double t90 = i > 0 ? features_detail::crossing(w, i, hi) : 0;
+	while(i > 0 && w[i-1] >= lo)
+		--i;
+	double t10 = i > 0 ? features_detail::crossing(w, i, lo) : 0;
+	f.rise = t90 - t10;
+	return f;
+}
+
+/* name, peak, argmax, integral, baseline and rise, tab separated. */
+inline void append_features(std::string& out, const std::string& name,
+		const waveform_features& f) {
+	char line[160];
+	snprintf(line, sizeof(line), "\t%d\t%u\t%.1f\t%.1f\t%.2f\n",
+			f.peak, f.argmax, f.integral, f.baseline, f.rise);
+	out += name;
+	out += line;
+}
+
+} // dew namespace
+
+#endif /* WAVEFORM_FEATURES_H_ */
@@ -0,0 +1,444 @@
+/*
+ * wire.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: schurchill
+ */
+
+#ifndef WIRE_H_
+#define WIRE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+namespace dew {
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Protobuf wire format, by hand, for the places where dewd handles messages
+ * as bytes rather than going through the generated classes.
+ */
+
+/* Base 128, least significant group first. */
+inline void append_varint(std::string& out, uint64_t n) {
+	while(n >= 0x80) {
+		out.push_back(static_cast<char>((n & 0x7f) | 0x80));
+		n >>= 7;
+	}
+	out.push_back(static_cast<char>(n));
+}
+
+/* A length delimited record, as writeDelimitedTo writes it. */
+inline void append_delimited(std::string& out, const std::string& message) {
+	append_varint(out, message.size());
+	out.append(message);
+}
+
+/* False when the varint runs past end or past ten bytes. */
+inline bool read_varint(const uint8_t*& p, const uint8_t* end, uint64_t& n) {
+	n = 0;
+	for(int shift = 0 ; p < end && shift < 70 ; shift += 7) {
+		uint8_t b = *p++;
+		n |= uint64_t(b & 0x7f) << shift;
+		if(b < 0x80)
+			return true;
+	}
+	return false;
+}
+
+/* Steps over one field's value.  Groups are not used by FloPointMessage and
+ * are refused.
+ */
+inline bool skip_field(const uint8_t*& p, const uint8_t* end, unsigned wire_type) {
+	uint64_t n;
+	switch(wire_type) {
+	case 0: return read_varint(p, end, n);
+	case 1: if(end - p < 8) return false; p += 8; return true;
+	case 2:
+		if(!read_varint(p, end, n) || n > uint64_t(end - p))
+			return false;
+		p += n;
+		return true;
+	case 5: if(end - p < 4) return false; p += 4; return true;
+	default: return false;
+	}
+}
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * What forward needs from a FloPointMessage, found without decoding it: the
+ * name, and the byte runs holding wheight's varints.  A run is either a packed
+ * field or one unpacked value, which reads the same.  Fields repeated on the
+ * wire follow protobuf's merge rules: the last name wins and wheight runs
+ * accumulate.
+ *
+ * The scan walks every field at the top level and inside the waveform, and
+ * fails on anything malformed there or on a missing name or waveform.  It
+ * also walks the other submessages (jitter, times, temperatures...), which
+ * dewd doesn't use, and fails where ParseFromString would: on anything
+ * malformed inside, or on a missing required field.  A required enum only
+ * counts when its value is one the generated classes know.  Repeated
+ * submessages must each be complete, while compile_info, the one optional
+ * submessage with a required field, merges like any other.
+ */
+struct byte_run {
+	const uint8_t* data;
+	size_t size;
+};
+
+struct flopoint_view {
+	const char* name = nullptr;
+	size_t name_size = 0;
+	std::vector<byte_run> wheight;
+
+	std::string name_string() const { return std::string(name, name_size); }
+};
+
+inline bool scan_waveform(const uint8_t* p, const uint8_t* end, flopoint_view& view) {
+	while(p < end) {
+		uint64_t tag;
+		if(!read_varint(p, end, tag) || (tag >> 3) == 0)
+			return false;
+		const uint8_t* value = p;
+		if(!skip_field(p, end, tag & 7))
+			return false;
+		if(tag == ((1 << 3) | 2)) {
+			uint64_t n;
+			read_varint(value, p, n);
+			view.wheight.push_back(byte_run{value, size_t(p - value)});
+		} else if(tag == ((1 << 3) | 0))
+			view.wheight.push_back(byte_run{value, size_t(p - value)});
+	}
+	return true;
+}
+
+/* Walks one of the submessages dewd doesn't use, field number field, and
+ * sets bit k - 1 of seen for each required field k it holds.  False when it
+ * is malformed.
+ */
+inline bool scan_unused(unsigned field, const uint8_t* p, const uint8_t* end, unsigned& seen) {
+	/* The largest value of the required enum at field 2, or -1 for none. */
+	int enum_max = field == 4 || field == 5 || field == 6 ? 2 : field == 9 ? 3 : -1;
+	while(p < end) {
+		uint64_t tag;
+		if(!read_varint(p, end, tag) || (tag >> 3) == 0)
+			return false;
+		const uint8_t* value = p;
+		if(!skip_field(p, end, tag & 7))
+			return false;
+		uint64_t n;
+		if(field == 3 && tag == ((1 << 3) | 2)) {
+			read_varint(value, p, n);
+			while(value < p)
+				if(!read_varint(value, p, n))
+					return false;
+		} else if(field == 7 && tag == ((1 << 3) | 2))
+			seen |= 1;
+		else if(enum_max >= 0 && tag == ((1 << 3) | 0))
+			seen |= 1;
+		else if(enum_max >= 0 && tag == ((2 << 3) | 0)) {
+			read_varint(value, p, n);
+			int32_t v = static_cast<int32_t>(n);
+			if(v >= 0 && v <= enum_max)
+				seen |= 2;
+		}
+	}
+	return true;
+}
+
+inline bool scan_flopoint(const std::string& message, flopoint_view& view) {
+	view.name = nullptr;
+	view.name_size = 0;
+	view.wheight.clear();
+	bool has_waveform = false;
+	bool has_compile_info = false;
+	unsigned compile_info_seen = 0;
+
+	auto p = reinterpret_cast<const uint8_t*>(message.data());
+	auto end = p + message.size();
+	while(p < end) {
+		uint64_t tag;
+		if(!read_varint(p, end, tag) || (tag >> 3) == 0)
+			return false;
+		const uint8_t* value = p;
+		if(!skip_field(p, end, tag & 7))
+			return false;
+		if((tag >> 3) == 1 || (tag >> 3) == 2) {
+			if((tag & 7) != 2)
+				return false;
+			uint64_t n;
+			read_varint(value, p, n);
+			if((tag >> 3) == 1) {
+				view.name = reinterpret_cast<const char*>(value);
+				view.name_size = p - value;
+			} else {
+				if(!scan_waveform(value, p, view))
+					return false;
+				has_waveform = true;
+			}
+		} else if((tag & 7) == 2 && (tag >> 3) >= 3 && (tag >> 3) <= 9 && (tag >> 3) != 8) {
+			unsigned field = tag >> 3;
+			uint64_t n;
+			read_varint(value, p, n);
+			unsigned seen = 0;
+			if(!scan_unused(field, value, p, seen))
+				return false;
+			if(field == 7) {
+				has_compile_info = true;
+				compile_info_seen |= seen;
+			} else if(field != 3 && seen != 3)
+				return false;
+		}
+	}
+	return view.name && has_waveform && (!has_compile_info || compile_info_seen);
+}
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Packed int32 decoding.
+ *
+ * A packed run holds one value per byte below 0x80, so the count is known
+ * before decoding and the values go straight into the caller's array.  The
+ * decoder reads each varint with one branch per byte and no loop, which
+ * lets the branch predictor run ahead through the one to three byte samples
+ * waveforms are made of.  Loads of eight bytes with the ends found from the
+ * top bits, pext, and a masked VByte style shuffle were all tried and were
+ * no faster on such data: each waits on the length of the varint before it.
+ *
+ * int32 keeps the low 32 bits of the varint, so bytes past the fifth only
+ * need to end it.
+ */
+namespace wire_detail {
+
+const uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+} // wire_detail namespace
+
+/* Values in a packed run: one per byte that ends a varint. */
+inline size_t count_varints(const uint8_t* p, size_t size) {
+	size_t ends = 0;
+	size_t i = 0;
+	for( ; i + 8 <= size ; i += 8) {
+		uint64_t w;
+		std::memcpy(&w, p + i, 8);
+		/* One bit per byte, summed by the multiply into the top byte. */
+		ends += (((~w & wire_detail::HIGH_BITS) >> 7) * 0x0101010101010101ULL) >> 56;
+	}
+	for( ; i < size ; ++i)
+		ends += p[i] < 0x80;
+	return ends;
+}
+
+/* Writes count_varints(p, size) values to out.  False when the run ends part
+ * way through a varint or holds one longer than ten bytes.
+ */
+inline bool decode_packed_int32(const uint8_t* p, size_t size, int32_t* out) {
+	const uint8_t* end = p + size;
+
+	/* Ten bytes always remain, so no byte needs a bounds check. */
+	while(end - p >= 10) {
+		uint32_t b, r;
+		b = *p++; r = b;         if(b < 0x80) goto done; r -= 0x80;
+		b = *p++; r += b << 7;   if(b < 0x80) goto done; r -= 0x80 << 7;
+		b = *p++; r += b << 14;  if(b < 0x80) goto done; r -= 0x80 << 14;
+		b = *p++; r += b << 21;  if(b < 0x80) goto done; r -= 0x80 << 21;
+		b = *p++; r += b << 28;  if(b < 0x80) goto done;
+		for(int i = 0 ; i < 5 ; ++i)
+			if(*p++ < 0x80)
+				goto done;
+		return false;
+	done:
+		*out++ = static_cast<int32_t>(r);
+	}
+
+	while(p < end) {
+		uint64_t n;
+		if(!read_varint(p, end, n))
+			return false;
+		*out++ = static_cast<int32_t>(n);
+	}
+	return true;
+}
+
+/* Every run, in order, into out. */
+inline bool decode_int32_runs(const std::vector<byte_run>& runs, std::vector<int32_t>& out) {
+	size_t n = 0;
+	for(auto& run : runs)
+		n += count_varints(run.data, run.size);
+	out.resize(n);
+
+	int32_t* at = out.data();
+	for(auto& run : runs) {
+		if(!decode_packed_int32(run.data, run.size, at))
+			return false;
+		at += count_varints(run.data, run.size);
+	}
+	return true;
+}
+
+/* A FloPointMessage holding only the name and a packed waveform, for frames
+ * that arrived without one.  ParseFromString reads it as the generated
+ * classes would have written it.
+ */
+inline void append_flopoint(std::string& out, const std::string& name,
+		const int32_t* samples, size_t n) {
+	std::string packed;
+	for(size_t i = 0 ; i < n ; ++i)
+		append_varint(packed, static_cast<uint64_t>(static_cast<int64_t>(samples[i])));
+	std::string waveform;
+	if(n) {
+		waveform.push_back((1 << 3) | 2);
+		append_delimited(waveform, packed);
+	}
+	out.push_back((1 << 3) | 2);
+	append_delimited(out, name);
+	out.push_back((2 << 3) | 2);
+	append_delimited(out, waveform);
+}
+
+/*-----------------------------------------------------------------------------
+ * October 18, 2026
+ *
+ * Raw waveform records, the second payload a device may put inside the FF FE
+ * frame.  The layout is fixed once the name, sample count and width are
+ * known:
+ *
+ *   offset   size   field
+ *   0        1      version, RAW_WAVEFORM_V1
+ *   1        1      name length, L
+ *   2        L      name
+ *   2+L      2      sample count, N, little endian
+ *   4+L      1      width, W
+ *   5+L      wN     samples, little endian
+ *
+ * and the payload is exactly 5+L+wN bytes.  The low nibble of W is w, the
+ * bytes each value takes, 2, 3 or 4, sign extended to int32.  With RAW_DELTA
+ * set the values are each sample less the one before, the first less zero,
+ * wrapping at 32 bits, and w is 2 or 3.  A waveform peaking near 65000 takes
+ * three bytes a sample, or two as deltas.
+ *
+ * A FloPointMessage can never begin with the version byte: 0x01 would be the
+ * tag of field 0, which protobuf does not allow.  Encoders put the name
+ * first, so protobuf payloads begin with 0x0A in practice.
+ */
+const uint8_t RAW_WAVEFORM_V1 = 0x01;
+const uint8_t RAW_DELTA = 0x10;
+
+inline bool is_raw_waveform(const std::string& message) {
+	return !message.empty() && static_cast<uint8_t>(message[0]) == RAW_WAVEFORM_V1;
+}
+
+/* n values of W bytes each from in, sign extended, summed when DELTA. */
+template<unsigned W, bool DELTA>
+inline void read_raw_samples(const uint8_t* in, size_t n, int32_t* out) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	if(W == 4 && !DELTA) {
+		std::memcpy(out, in, 4 * n);
+		return;
+	}
+#endif
+	const unsigned shift = 32 - 8 * W;
+	uint32_t last = 0;
+	for(size_t i = 0 ; i < n ; ++i, in += W) {
+		uint32_t v = in[0] | uint32_t(in[1]) << 8;
+		if(W > 2)
+			v |= uint32_t(in[2]) << 16;
+		if(W > 3)
+			v |= uint32_t(in[3]) << 24;
+		v = static_cast<uint32_t>(static_cast<int32_t>(v << shift) >> shift);
+		if(DELTA)
+			v = last += v;
+		out[i] = static_cast<int32_t>(v);
+	}
+}
+
+/* The name into view, pointing into message, and the samples into out.
+ * False when the width is unknown or the lengths don't add up to the size of
+ * the payload.
+ */
+inline bool read_raw_waveform(const std::string& message, flopoint_view& view,
+		std::vector<int32_t>& out) {
+	auto p = reinterpret_cast<const uint8_t*>(message.data());
+	size_t size = message.size();
+	if(size < 5 || p[0] != RAW_WAVEFORM_V1)
+		return false;
+	size_t name_size = p[1];
+	if(size < 5 + name_size)
+		return false;
+	size_t n = p[2 + name_size] | size_t(p[3 + name_size]) << 8;
+	uint8_t width = p[4 + name_size];
+	size_t w = width & 0x0f;
+	bool delta = width & RAW_DELTA;
+	if((width & ~(RAW_DELTA | 0x0f)) || w < 2 || w > (delta ? 3 : 4))
+		return false;
+	if(size != 5 + name_size + w * n)
+		return false;
+
+	view.name = message.data() + 2;
+	view.name_size = name_size;
+	view.wheight.clear();
+
+	out.resize(n);
+	const uint8_t* in = p + 5 + name_size;
+	switch(width) {
+	case 2: read_raw_samples<2, false>(in, n, out.data()); break;
+	case 3: read_raw_samples<3, false>(in, n, out.data()); break;
+	case 4: read_raw_samples<4, false>(in, n, out.data()); break;
+	case RAW_DELTA | 2: read_raw_samples<2, true>(in, n, out.data()); break;
+	default: read_raw_samples<3, true>(in, n, out.data()); break;
+	}
+	return true;
+}
+
+/* Appends the record in the narrowest width that holds the samples, plain
+ * when that is no wider than deltas.  False when the name or the sample
+ * count is too long for the layout.
+ */
+inline bool append_raw_waveform(std::string& out, const std::string& name,
+		const int32_t* samples, size_t n) {
+	if(name.size() > 0xff || n > 0xffff)
+		return false;
+
+	/* The bytes a value needs, sign extended. */
+	auto bytes = [](int32_t v) -> size_t {
+		return v >= -0x8000 && v < 0x8000 ? 2 : v >= -0x800000 && v < 0x800000 ? 3 : 4;
+	};
+	size_t plain = 2, delta = 2;
+	uint32_t last = 0;
+	for(size_t i = 0 ; i < n ; ++i) {
+		uint32_t v = static_cast<uint32_t>(samples[i]);
+		plain = std::max(plain, bytes(samples[i]));
+		delta = std::max(delta, bytes(static_cast<int32_t>(v - last)));
+		last = v;
+	}
+	bool use_delta = delta < plain;
+	size_t w = use_delta ? delta : plain;
+
+	out.push_back(static_cast<char>(RAW_WAVEFORM_V1));
+	out.push_back(static_cast<char>(name.size()));
+	out.append(name);
+	out.push_back(static_cast<char>(n & 0xff));
+	out.push_back(static_cast<char>(n >> 8));
+	out.push_back(static_cast<char>(w | (use_delta ? RAW_DELTA : 0)));
+	last = 0;
+	for(size_t i = 0 ; i < n ; ++i) {
+		uint32_t v = static_cast<uint32_t>(samples[i]);
+		uint32_t value = use_delta ? v - last : v;
+		last = v;
+		for(size_t b = 0 ; b < w ; ++b)
+			out.push_back(static_cast<char>((value >> 8 * b) & 0xff));
+	}
+	return true;
+}
+
+} // dew namespace
+
+#endif /* WIRE_H_ */
@@ -0,0 +1,128 @@
+/* Linger check
+ *
+ * A client that doesn't end its requests with a newline has each one run
+ * once the connection has been quiet for LINGER.  This sends such requests
+ * with quiet gaps longer than LINGER between them, then a pipelined pair,
+ * and checks that every request gets its own answer and no stale one.
+ *
+ * The dispatcher and the network session run in process, on one io_service,
+ * with a real TCP connection between the session and the client.
+ *
+ * Built apart from dewd, from the repository root:
+ *
+ *   g++ -std=gnu++11 -O2 -include fppb/flopointpb.pb.h -Isrc \
+ *     test/linger_check.cpp fppb/flopointpb.pb.cc -o linger_check \
+ *     -lprotobuf -lboost_system -lboost_chrono -lboost_program_options \
+ *     -lboost_filesystem -lpthread
+ *
+ * Exits 0 when every step passes.
+ */
+
+#include <ctime>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include "structs.h"
+#include "types.h"
+#include "utils.h"
+
+#include "network_session.hpp"
+#include "metrics_session.hpp"
+#include "command_graph.hpp"
+
+#include "session.hpp"
+#include "serial_session.hpp"
+
+
+
+using namespace dew;
+
+using ::boost::asio::io_service;
+using ::boost::asio::ip::tcp;
+
+using ::boost::chrono::steady_clock;
+using ::boost::chrono::milliseconds;
+
+using ::std::string;
+using ::std::make_shared;
+
+namespace
+{
+
+/* Runs the io_service for a while, as the daemon would between reads. */
+void run_for(io_service& service, milliseconds wait) {
+	auto until = steady_clock::now() + wait;
+	while(steady_clock::now() < until) {
+		service.poll();
+		service.reset();
+		usleep(1000);
+	}
+}
+
+string take(tcp::socket& client) {
+	string out;
+	while(size_t n = client.available()) {
+		string part (n, '\0');
+		client.read_some(boost::asio::buffer(&part[0], n));
+		out += part;
+	}
+	return out;
+}
+
+bool step(const char* label, const string& got, const string& wanted, bool prefix) {
+	bool pass = prefix ? got.compare(0, wanted.size(), wanted) == 0 : got == wanted;
+	printf("%-34s %s\n", label, pass ? "pass" : "FAIL");
+	if(!pass)
+		printf("  wanted %s%s\n  got    %s\n", prefix ? "a reply starting " : "",
+				wanted.c_str(), got.c_str());
+	return pass;
+}
+
+} //namespace
+
+
+
+int main() {
+	auto service = make_shared<io_service>();
+	context_struct_lite context (service);
+	auto dis = make_shared<dispatcher>(service);
+	dis->build_command_tree();
+
+	tcp::acceptor acceptor (*service, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+	tcp::socket client (*service);
+	tcp::socket server (*service);
+	client.connect(acceptor.local_endpoint());
+	acceptor.accept(server);
+	auto session = make_shared<ns>(context_struct(context, dis), server);
+	session->start_read();
+
+	/* Well past LINGER, so each request has been run before the next. */
+	const milliseconds quiet (200);
+	auto send = [&](const string& request) {
+		boost::asio::write(client, boost::asio::buffer(request));
+		run_for(*service, quiet);
+		return take(client);
+	};
+
+	bool pass = true;
+	pass &= step("unterminated get help", send("get help"), "get_help called.\n", false);
+	pass &= step("unterminated subscribe help", send("subscribe help"),
+			"Usage: subscribe to <channel>", true);
+	pass &= step("unterminated get help again", send("get help"), "get_help called.\n", false);
+	pass &= step("pipelined get help, get help", send("get help\nget help\n"),
+			"get_help called.\nget_help called.\n", false);
+	pass &= step("terminated get help", send("get help\n"), "get_help called.\n", false);
+
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+/* Scan check
+ *
+ * scan_flopoint must accept a FloPointMessage exactly when ParseFromString
+ * does, since forward republishes the bytes it accepts to clients that parse
+ * them.  This runs both over:
+ *
+ *   - named cases, among them submessages missing a required field and a
+ *     required enum holding a value the generated classes don't know
+ *   - random messages built with the generated classes, where every
+ *     required field of every submessage may be left out, serialized with
+ *     SerializePartialToString
+ *   - every truncation of some of those
+ *
+ * and checks that they agree, and on the name and samples when both accept.
+ *
+ * Built apart from dewd, from the repository root:
+ *
+ *   g++ -std=gnu++11 -O2 -include fppb/flopointpb.pb.h -Isrc \
+ *     test/scan_check.cpp fppb/flopointpb.pb.cc -o scan_check \
+ *     -lprotobuf -lpthread
+ *
+ * Exits 0 when every step passes.
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "wire.h"
+
+
+
+using namespace dew;
+
+using ::std::string;
+using ::std::vector;
+
+typedef flopointpb::FloPointMessage fpm;
+
+namespace
+{
+
+/* Empty when both agree, otherwise what each said. */
+string disagreement(const string& message) {
+	fpm parsed;
+	bool parses = parsed.ParseFromString(message);
+	flopoint_view view;
+	vector<int32_t> samples;
+	bool scans = scan_flopoint(message, view) && decode_int32_runs(view.wheight, samples);
+	if(parses != scans)
+		return string("ParseFromString ") + (parses ? "accepts" : "rejects")
+				+ ", scan_flopoint " + (scans ? "accepts" : "rejects");
+	if(parses && (view.name_string() != parsed.name()
+			|| samples != vector<int32_t>(parsed.waveform().wheight().begin(),
+					parsed.waveform().wheight().end())))
+		return "name or samples differ";
+	return "";
+}
+
+bool step(const char* label, const string& got) {
+	printf("%-40s %s\n", label, got.empty() ? "pass" : "FAIL");
+	if(!got.empty())
+		printf("  %s\n", got.c_str());
+	return got.empty();
+}
+
+/* A message with the required top level fields and a few samples. */
+fpm base() {
+	fpm m;
+	m.set_name("3of09");
+	for(int i = 0 ; i < 8 ; ++i)
+		m.mutable_waveform()->add_wheight(i * 1000);
+	return m;
+}
+
+string partial(const fpm& m) {
+	string out;
+	m.SerializePartialToString(&out);
+	return out;
+}
+
+/* Leaves out each field with probability one in four. */
+fpm random_message(std::mt19937& rng) {
+	auto keep = [&]{ return rng() % 4 != 0; };
+	fpm m;
+	if(keep())
+		m.set_name("name" + std::to_string(rng() % 10));
+	if(keep())
+		for(int i = 0, n = rng() % 20 ; i < n ; ++i)
+			m.mutable_waveform()->add_wheight(int32_t(rng() % 200000) - 1000);
+	if(rng() % 2)
+		for(int i = 0, n = rng() % 5 ; i < n ; ++i)
+			m.mutable_jitter()->add_jheight(rng() % 100);
+	for(int i = 0, n = rng() % 3 ; i < n ; ++i) {
+		auto t = m.add_time_reading();
+		if(keep()) t->set_time_point(rng());
+		if(keep()) t->set_time_source(fpm::TimeSource(rng() % 3));
+	}
+	for(int i = 0, n = rng() % 3 ; i < n ; ++i) {
+		auto t = m.add_temp_reading();
+		if(keep()) t->set_temp_point(rng() % 100);
+		if(keep()) t->set_temp_source(fpm::TempSource(rng() % 3));
+	}
+	for(int i = 0, n = rng() % 3 ; i < n ; ++i) {
+		auto v = m.add_volt_reading();
+		if(keep()) v->set_volt_point(rng() % 100);
+		if(keep()) v->set_volt_source(fpm::VoltSource(rng() % 3));
+	}
+	for(int i = 0, n = rng() % 3 ; i < n ; ++i) {
+		auto c = m.add_count();
+		if(keep()) c->set_count_value(rng() % 100);
+		if(keep()) c->set_count_type(fpm::CountType(rng() % 4));
+	}
+	if(rng() % 2) {
+		auto c = m.mutable_compile_info();
+		if(keep()) c->set_compiler("gcc");
+		if(keep()) c->set_date("2026-10-18");
+	}
+	if(rng() % 2)
+		m.set_dipswitches(rng() % 256);
+	return m;
+}
+
+} //namespace
+
+
+
+int main() {
+	/* Every rejected parse would log an error otherwise. */
+	google::protobuf::SetLogHandler(nullptr);
+
+	bool pass = true;
+
+	fpm m = base();
+	pass &= step("plain message", disagreement(partial(m)));
+
+	m = base();
+	m.add_time_reading()->set_time_point(1);
+	pass &= step("time without its source", disagreement(partial(m)));
+
+	m = base();
+	m.add_temp_reading()->set_temp_source(fpm::THERM1);
+	pass &= step("temp without its point", disagreement(partial(m)));
+
+	m = base();
+	m.add_volt_reading()->set_volt_point(5);
+	pass &= step("volt without its source", disagreement(partial(m)));
+
+	m = base();
+	m.add_count()->set_count_type(fpm::UPTIME);
+	pass &= step("count without its value", disagreement(partial(m)));
+
+	m = base();
+	m.mutable_compile_info()->set_date("today");
+	pass &= step("compile_info without its compiler", disagreement(partial(m)));
+
+	m = base();
+	auto t = m.add_time_reading();
+	t->set_time_point(1);
+	t->set_time_source(fpm::CLOCK2);
+	m.add_time_reading()->set_time_point(2);
+	pass &= step("second time incomplete", disagreement(partial(m)));
+
+	/* compile_info merges, so its compiler may arrive in an earlier copy. */
+	string merged = partial(base());
+	m.Clear();
+	m.mutable_compile_info()->set_compiler("gcc");
+	merged += partial(m);
+	m.Clear();
+	m.mutable_compile_info()->set_date("today");
+	merged += partial(m);
+	pass &= step("compile_info merged over two copies", disagreement(merged));
+
+	/* Field 4, a Time whose source is 7, which TimeSource doesn't have. */
+	string unknown_enum = partial(base()) + string("\x22\x04\x08\x01\x10\x07", 6);
+	pass &= step("time source out of range", disagreement(unknown_enum));
+
+	/* Field 3, a Jitter holding a packed run cut off inside a varint. */
+	string bad_jitter = partial(base()) + string("\x1a\x03\x0a\x01\x80", 5);
+	pass &= step("jitter with a broken packed run", disagreement(bad_jitter));
+
+	std::mt19937 rng (1);
+	string random_result, truncated_result;
+	size_t accepted = 0;
+	for(int i = 0 ; i < 20000 && random_result.empty() ; ++i) {
+		string message = partial(random_message(rng));
+		random_result = disagreement(message);
+		if(!random_result.empty())
+			random_result += " on random message " + std::to_string(i);
+		accepted += fpm().ParseFromString(message);
+		if(i % 20 == 0)
+			for(size_t k = 0 ; k < message.size() && truncated_result.empty() ; ++k) {
+				truncated_result = disagreement(message.substr(0, k));
+				if(!truncated_result.empty())
+					truncated_result += " on random message " + std::to_string(i)
+							+ " cut to " + std::to_string(k) + " bytes";
+			}
+	}
+	pass &= step("20000 random messages", random_result);
+	pass &= step("truncations of every 20th", truncated_result);
+	printf("%zu of the random messages parse\n", accepted);
+
+	return pass ? 0 : 1;
+}